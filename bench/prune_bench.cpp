@@ -0,0 +1,91 @@
+#include "schema_miner.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+
+/*
+    Compare the pruning strategies (filt, semi-join, registry, fused) on layers 2-5.
+    Each strategy mines in its own in-memory database so neither benefits from
+    the other's caches. Layer 1 is shared work and is not timed.
+
+    Usage: prune_bench [csv path] [attribute count]
+*/
+
+const int FIRST_LAYER = 2;
+const int LAST_LAYER = 5;
+
+class PruneBenchmark : public SchemaMiner {
+public:
+    using SchemaMiner::SchemaMiner;
+
+    std::vector<long> timeLayers() {
+        std::vector<long> timings;
+        computeFirstLayer();
+
+        for (int layer = FIRST_LAYER; layer <= LAST_LAYER && layer <= attributeCount; layer++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            int hasResults = computeSingleLayer(layer);
+            auto end = std::chrono::high_resolution_clock::now();
+            timings.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+
+            if (!hasResults) {
+                break;
+            }
+        }
+        return timings;
+    }
+
+    std::string layerEntropies(int n) {
+        auto result = conn.Query("SELECT out.entropies FROM l" + std::to_string(n) + ";");
+        return result->HasError() ? "" : result->GetValue(0, 0).ToString();
+    }
+};
+
+int main(int argc, char* argv[]) {
+    std::string csvPath = argc > 1 ? argv[1] : "./dataviz/datasets/small_flights.csv";
+    int attributeCount = argc > 2 ? std::stoi(argv[2]) : 19;
+
+    std::vector<std::pair<std::string, PruneStrategy>> strategies = {
+        {"filt", PruneStrategy::Filt},
+        {"semi-join", PruneStrategy::SemiJoin},
+        {"registry", PruneStrategy::Registry},
+        {"fused", PruneStrategy::Fused}
+    };
+
+    std::vector<std::unique_ptr<PruneBenchmark>> miners;
+    std::vector<std::vector<long>> timings;
+    size_t layerCount = 0;
+    for (const auto& [name, strategy] : strategies) {
+        miners.push_back(std::make_unique<PruneBenchmark>(csvPath, attributeCount, strategy));
+        miners.back()->setPrintLayers(false);
+        // Layer tables are compared after mining
+        miners.back()->setKeepLayerTables(true);
+        timings.push_back(miners.back()->timeLayers());
+        layerCount = std::max(layerCount, timings.back().size());
+    }
+
+    std::cout << "layer";
+    for (const auto& [name, strategy] : strategies) {
+        std::cout << "\t" << name << " (ms)";
+    }
+    std::cout << "\tmatch\n";
+
+    for (size_t i = 0; i < layerCount; i++) {
+        int layer = FIRST_LAYER + i;
+        std::cout << layer;
+
+        // Every strategy must agree with the filt baseline
+        bool match = true;
+        auto baseline = miners[0]->layerEntropies(layer);
+        for (size_t s = 0; s < strategies.size(); s++) {
+            std::cout << "\t" << (i < timings[s].size() ? std::to_string(timings[s][i]) : "-");
+            match = match && miners[s]->layerEntropies(layer) == baseline;
+        }
+        std::cout << "\t" << (match ? "yes" : "NO") << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "duckdb.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define EYTZINGER_AVX2
+#endif
+
+/*
+Survivor hashes laid out in Eytzinger (BFS) order: the sorted values stored as an
+implicit binary search tree where node i has children 2i+1 and 2i+2. Compared to a
+hash table this is just the values themselves (so it can be stored as-is in a layer
+table's UBIGINT list), and a probe costs a fixed log2(n) steps whatever the data.
+
+Probes are branchless and run BATCH_SIZE keys in lockstep so their memory accesses
+overlap, with the cache line four levels down prefetched at each step. On x86 CPUs
+with AVX2 the descent runs 4 keys per instruction using gathers.
+*/
+
+namespace eytzinger {
+
+using hash_t = uint64_t;
+
+const idx_t BATCH_SIZE = 8;
+
+// Number of tree levels holding n nodes
+inline idx_t levelCount(idx_t n) {
+    idx_t levels = 0;
+    while (n > 0) {
+        levels++;
+        n >>= 1;
+    }
+    return levels;
+}
+
+inline void prefetch(const hash_t *addr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(addr);
+#endif
+}
+
+/*
+    Lay out sorted values in Eytzinger order.
+*/
+std::vector<hash_t> build(const std::vector<hash_t> &sorted) {
+    std::vector<hash_t> tree(sorted.size());
+    idx_t next = 0;
+
+    // In-order traversal of the implicit tree visits nodes in sorted order
+    std::function<void(idx_t)> fill = [&](idx_t node) {
+        if (node >= tree.size()) {
+            return;
+        }
+        fill(2 * node + 1);
+        tree[node] = sorted[next++];
+        fill(2 * node + 2);
+    };
+
+    fill(0);
+    return tree;
+}
+
+/*
+    Once a descent has left the tree at pos, the lower bound of key is the last
+    node where it went left: strip the trailing right turns (1-bits) of pos + 1.
+*/
+inline bool resolve(const hash_t *tree, hash_t key, idx_t pos) {
+    uint64_t node = pos + 1;
+    while (node & 1) {
+        node >>= 1;
+    }
+    node >>= 1;
+    return node != 0 && tree[node - 1] == key;
+}
+
+/*
+    One branchless step down from pos for every key. The first (levelCount - 1)
+    levels are full; on the last level keys already past the end stay put.
+*/
+inline void descend(const hash_t *tree, idx_t n, const hash_t *keys, idx_t *pos) {
+    auto fullLevels = levelCount(n) - 1;
+    for (idx_t level = 0; level < fullLevels; level++) {
+        for (idx_t k = 0; k < BATCH_SIZE; k++) {
+            prefetch(tree + 16 * pos[k] + 15);
+            pos[k] = 2 * pos[k] + 1 + (tree[pos[k]] < keys[k]);
+        }
+    }
+    for (idx_t k = 0; k < BATCH_SIZE; k++) {
+        bool inTree = pos[k] < n;
+        idx_t step = 2 * pos[k] + 1 + (tree[inTree ? pos[k] : 0] < keys[k]);
+        pos[k] = inTree ? step : pos[k];
+    }
+}
+
+#ifdef EYTZINGER_AVX2
+/*
+    As descend, 4 keys per instruction. Hashes are unsigned, so both sides are
+    shifted by the sign bit before the signed 64-bit comparison.
+*/
+__attribute__((target("avx2"))) void descendAvx2(const hash_t *tree, idx_t n, const hash_t *keys, idx_t *pos) {
+    auto fullLevels = levelCount(n) - 1;
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i one = _mm256_set1_epi64x(1);
+    auto base = (const long long *)tree;
+
+    for (idx_t half = 0; half < BATCH_SIZE; half += 4) {
+        __m256i key = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(keys + half)), sign);
+        __m256i node = _mm256_setzero_si256();
+
+        for (idx_t level = 0; level < fullLevels; level++) {
+            __m256i ahead = _mm256_add_epi64(_mm256_slli_epi64(node, 4), _mm256_set1_epi64x(15));
+            prefetch(tree + _mm256_extract_epi64(ahead, 0));
+            prefetch(tree + _mm256_extract_epi64(ahead, 1));
+            prefetch(tree + _mm256_extract_epi64(ahead, 2));
+            prefetch(tree + _mm256_extract_epi64(ahead, 3));
+
+            __m256i val = _mm256_xor_si256(_mm256_i64gather_epi64(base, node, 8), sign);
+            __m256i less = _mm256_cmpgt_epi64(key, val); // -1 where tree[node] < key
+            node = _mm256_sub_epi64(_mm256_add_epi64(_mm256_add_epi64(node, node), one), less);
+        }
+
+        __m256i inTree = _mm256_cmpgt_epi64(_mm256_set1_epi64x(n), node);
+        __m256i val = _mm256_xor_si256(_mm256_i64gather_epi64(base, _mm256_and_si256(node, inTree), 8), sign);
+        __m256i less = _mm256_cmpgt_epi64(key, val);
+        __m256i step = _mm256_sub_epi64(_mm256_add_epi64(_mm256_add_epi64(node, node), one), less);
+        node = _mm256_blendv_epi8(node, step, inTree);
+
+        _mm256_storeu_si256((__m256i *)(pos + half), node);
+    }
+}
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+/*
+    found[i] = keys[i] is in the tree of n values.
+*/
+void containsBatch(const hash_t *tree, idx_t n, const hash_t *keys, idx_t count, bool *found) {
+    if (n == 0) {
+        std::fill(found, found + count, false);
+        return;
+    }
+
+    hash_t batchKeys[BATCH_SIZE];
+    idx_t pos[BATCH_SIZE];
+    for (idx_t start = 0; start < count; start += BATCH_SIZE) {
+        auto batchCount = std::min(BATCH_SIZE, count - start);
+        for (idx_t k = 0; k < BATCH_SIZE; k++) {
+            batchKeys[k] = k < batchCount ? keys[start + k] : 0;
+            pos[k] = 0;
+        }
+
+#ifdef EYTZINGER_AVX2
+        if (hasAvx2()) {
+            descendAvx2(tree, n, batchKeys, pos);
+        } else {
+            descend(tree, n, batchKeys, pos);
+        }
+#else
+        descend(tree, n, batchKeys, pos);
+#endif
+
+        for (idx_t k = 0; k < batchCount; k++) {
+            found[start + k] = resolve(tree, batchKeys[k], pos[k]);
+        }
+    }
+}
+
+/*
+    Keep the rows whose key is in the tree. keys[i] belongs to rows[i]; both are
+    compacted in place and the number of rows kept is returned.
+*/
+idx_t filterRows(const hash_t *tree, idx_t n, hash_t *keys, idx_t *rows, idx_t count) {
+    bool found[STANDARD_VECTOR_SIZE];
+    idx_t kept = 0;
+    for (idx_t start = 0; start < count; start += STANDARD_VECTOR_SIZE) {
+        auto chunkCount = std::min<idx_t>(STANDARD_VECTOR_SIZE, count - start);
+        containsBatch(tree, n, keys + start, chunkCount, found);
+        for (idx_t i = 0; i < chunkCount; i++) {
+            keys[kept] = keys[start + i];
+            rows[kept] = rows[start + i];
+            kept += found[i];
+        }
+    }
+    return kept;
+}
+
+} // namespace eytzinger
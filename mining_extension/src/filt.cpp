@@ -4,19 +4,78 @@
 
 namespace filt {
 
+/*
+    Probe each row's hash against an Eytzinger-ordered set of n survivors.
+*/
+void probeSurvivors(duckdb::Vector &searchAtt, const uint64_t *tree, idx_t n, idx_t rowCount, duckdb::Vector &result) {
+    duckdb::UnifiedVectorFormat searchData;
+    searchAtt.ToUnifiedFormat(rowCount, searchData);
+    auto searchVals = duckdb::UnifiedVectorFormat::GetData<uint64_t>(searchData);
+
+    uint64_t keys[STANDARD_VECTOR_SIZE];
+    for (idx_t row = 0; row < rowCount; row++) {
+        keys[row] = searchVals[searchData.sel->get_index(row)];
+    }
+
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    auto found = duckdb::FlatVector::GetData<bool>(result);
+    eytzinger::containsBatch(tree, n, keys, rowCount, found);
+
+    // NULL hashes are never survivors
+    for (idx_t row = 0; row < rowCount; row++) {
+        found[row] = found[row] && searchData.validity.RowIsValid(searchData.sel->get_index(row));
+    }
+}
+
 void filtFunction(duckdb::DataChunk &args, duckdb::ExpressionState &state, duckdb::Vector &result) {
     auto rowCount = args.size();
-    auto searchAtt = args.data[0]; // Value we're searching for in the set of valid hashes
-    auto validAtts = args.data[1]; // LIST(LIST(UBIGINT)). List of non-unique atts for each set
-    auto validAttList = duckdb::ListValue::GetChildren(validAtts.GetValue(0));
+    auto &searchAtt = args.data[0]; // Value we're searching for in the set of valid hashes
+    auto &validAtts = args.data[1]; // LIST(LIST(UBIGINT)). List of non-unique atts for each set
     auto setOffset = args.data[2].GetValue(0).GetValue<int>();
 
-    for (size_t row = 0; row < rowCount; ++row) {
-        auto searchVal = searchAtt.GetValue(row);
-        auto validVals = duckdb::ListValue::GetChildren(validAttList[setOffset]);
-        bool found = std::find(validVals.begin(), validVals.end(), searchVal) != validVals.end();
-        result.SetValue(row, duckdb::Value::BOOLEAN(found));
+    // Read the survivors of set [setOffset] in place (single-row l[n-1], so row 0)
+    duckdb::UnifiedVectorFormat validData;
+    validAtts.ToUnifiedFormat(rowCount, validData);
+    auto setList = duckdb::UnifiedVectorFormat::GetData<duckdb::list_entry_t>(validData)[validData.sel->get_index(0)];
+    auto &sets = duckdb::ListVector::GetEntry(validAtts);
+    auto validVals = duckdb::FlatVector::GetData<duckdb::list_entry_t>(sets)[setList.offset + setOffset];
+    auto tree = duckdb::FlatVector::GetData<uint64_t>(duckdb::ListVector::GetEntry(sets)) + validVals.offset;
+
+    probeSurvivors(searchAtt, tree, validVals.length, rowCount, result);
+}
+
+// filt(hash, key, offset): survivors are looked up once at bind time from the cache
+struct FiltCachedBindData : public duckdb::FunctionData {
+    duckdb::shared_ptr<survivorCache::SurvivorEntry> entry;
+    idx_t offset;
+
+    FiltCachedBindData(duckdb::shared_ptr<survivorCache::SurvivorEntry> entry, idx_t offset) : entry(std::move(entry)), offset(offset) {}
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<FiltCachedBindData>(entry, offset);
     }
+
+    bool Equals(const duckdb::FunctionData &other) const override {
+        auto &otherData = other.Cast<FiltCachedBindData>();
+        return entry == otherData.entry && offset == otherData.offset;
+    }
+};
+
+duckdb::unique_ptr<duckdb::FunctionData> filtCachedBind(duckdb::ClientContext &context, duckdb::ScalarFunction &function, duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> &arguments) {
+    auto key = survivorCache::bindConstant(context, *arguments[1], "key").ToString();
+    auto offset = survivorCache::bindConstant(context, *arguments[2], "offset").GetValue<int32_t>();
+
+    auto entry = survivorCache::lookupSurvivors(context, key);
+    if (offset < 0 || offset >= (int32_t) entry->sets.size()) {
+        throw duckdb::BinderException("Set offset %d out of range for survivors '%s'", offset, key);
+    }
+    return duckdb::make_uniq<FiltCachedBindData>(std::move(entry), offset);
+}
+
+void filtCachedFunction(duckdb::DataChunk &args, duckdb::ExpressionState &state, duckdb::Vector &result) {
+    auto &bindData = state.expr.Cast<duckdb::BoundFunctionExpression>().bind_info->Cast<FiltCachedBindData>();
+    auto &validVals = bindData.entry->sets[bindData.offset];
+    probeSurvivors(args.data[0], validVals.data(), validVals.size(), args.size(), result);
 }
 
 } // namespace filt
\ No newline at end of file
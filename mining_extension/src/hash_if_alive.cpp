@@ -0,0 +1,442 @@
+#include "duckdb.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+
+#include "lattice.hpp"
+
+/*
+hash_if_alive(key, n, col0, col1, ...): fused pruning + hashing for layer n.
+Returns one UBIGINT per n-set (lexicographic order), NULL where the tuple doesn't
+survive every (n-1)-subset registered under key. With hash_if_alive(key, prev_sets,
+sets, col0, ...) the layouts of the previous and current layer are given explicitly
+instead (lists of column index lists). Equivalent to
+
+    [CASE WHEN filt(hash_list(<subset>), key, <offset>) AND ... THEN hash_list(<set>) END, ...]
+
+but each column is hashed once per chunk, subset hashes are only combined for rows
+still alive, and the candidate hash is derived from its prefix subset's hash.
+
+Subsets are probed most selective first. The order starts from each subset's pass
+rate in the previous layer and adapts to the pass rates observed per chunk.
+*/
+
+namespace hashIfAlive {
+
+using hash_t = uint64_t;
+
+struct Candidate {
+    lattice::AttrMask atts;
+    // (n-1)-subsets as (atts, offset in previous layer). subsets[0] is the prefix
+    // (candidate minus its last att.), whose hash extends to the candidate hash
+    std::vector<std::pair<lattice::AttrMask, idx_t>> subsets;
+    // Some subset has no survivors, so no tuple can survive this set
+    bool dead = false;
+};
+
+// Weight (in probed rows) of the previous layer's pass rate against observed rates
+const double PRIOR_WEIGHT = 1024.0;
+
+// Per-thread probe statistics for each (n-1)-set, accumulated across chunks
+struct ProbeStats : public duckdb::FunctionLocalState {
+    std::vector<uint64_t> probed;
+    std::vector<uint64_t> passed;
+
+    explicit ProbeStats(idx_t setCount) : probed(setCount, 0), passed(setCount, 0) {}
+
+    double passRate(const survivorCache::SurvivorEntry &entry, idx_t set) const {
+        return (passed[set] + PRIOR_WEIGHT * entry.passRate(set)) / (probed[set] + PRIOR_WEIGHT);
+    }
+};
+
+struct HashIfAliveBindData : public duckdb::FunctionData {
+    duckdb::shared_ptr<survivorCache::SurvivorEntry> entry;
+    duckdb::shared_ptr<std::vector<Candidate>> candidates;
+
+    HashIfAliveBindData(duckdb::shared_ptr<survivorCache::SurvivorEntry> entry, duckdb::shared_ptr<std::vector<Candidate>> candidates) :
+        entry(std::move(entry)), candidates(std::move(candidates)) {}
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<HashIfAliveBindData>(entry, candidates);
+    }
+
+    bool Equals(const duckdb::FunctionData &other) const override {
+        auto &otherData = other.Cast<HashIfAliveBindData>();
+        return entry == otherData.entry && candidates == otherData.candidates;
+    }
+};
+
+/*
+    Generate all k-set combinations of attCount attributes in lexicographic order
+    (the order layers are laid out in).
+*/
+std::vector<lattice::AttrMask> getCombinations(int attCount, int k) {
+    std::vector<lattice::AttrMask> combinations;
+
+    std::function<void(lattice::AttrMask, int, int)> generateCombinations = [&](lattice::AttrMask atts, int start, int k) {
+        if (k == 0) {
+            combinations.push_back(atts);
+            return;
+        }
+
+        for (int i = start; i <= attCount - k; i++) {
+            generateCombinations(lattice::withAtt(atts, i), i + 1, k - 1);
+        }
+    };
+
+    generateCombinations(0, 0, k);
+    return combinations;
+}
+
+/*
+    Candidates for the given n-sets, with the offsets of their (n-1)-subsets in
+    prevSets (the previous layer, whose survivors are given). A subset missing
+    from prevSets was pruned as a key earlier, so the candidate is dead.
+*/
+duckdb::shared_ptr<std::vector<Candidate>> makeCandidates(const std::vector<lattice::AttrMask> &prevSets, const std::vector<lattice::AttrMask> &sets, const survivorCache::SurvivorEntry &entry) {
+    lattice::LayerIndex prevIndex(prevSets);
+
+    auto candidates = duckdb::make_shared_ptr<std::vector<Candidate>>();
+    for (const auto& atts : sets) {
+        Candidate candidate;
+        auto attList = lattice::toAtts(atts);
+        auto ranks = lattice::subsetRanks(atts);
+        // Drop atts. from the back so the prefix comes first
+        for (int drop = attList.size() - 1; drop >= 0; drop--) {
+            auto subset = lattice::withoutAtt(atts, attList[drop]);
+            auto prev = prevIndex.findRank(ranks[drop]);
+            idx_t offset = prev < 0 ? 0 : prev;
+            candidate.dead = candidate.dead || prev < 0 || entry.sets[offset].empty();
+            candidate.subsets.emplace_back(subset, offset);
+        }
+        candidate.atts = atts;
+        candidates->push_back(std::move(candidate));
+    }
+    return candidates;
+}
+
+// Set offsets are colex ranks, which are only defined for up to 64 columns
+void checkAttCount(int attCount) {
+    if (attCount > lattice::MAX_ATTRIBUTES) {
+        throw duckdb::BinderException("hash_if_alive supports at most %d columns, got %d", lattice::MAX_ATTRIBUTES, attCount);
+    }
+}
+
+duckdb::shared_ptr<survivorCache::SurvivorEntry> bindSurvivors(duckdb::ClientContext &context, const std::string &key, idx_t prevSetCount) {
+    auto entry = survivorCache::lookupSurvivors(context, key);
+    if (prevSetCount != entry->sets.size()) {
+        throw duckdb::BinderException("Survivors '%s' hold %llu sets, expected %llu", key, entry->sets.size(), prevSetCount);
+    }
+    return entry;
+}
+
+// hash_if_alive(key, n, col...): every n-set of the columns
+duckdb::unique_ptr<duckdb::FunctionData> hashIfAliveBind(duckdb::ClientContext &context, duckdb::ScalarFunction &function, duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> &arguments) {
+    auto key = survivorCache::bindConstant(context, *arguments[0], "key").ToString();
+    auto n = survivorCache::bindConstant(context, *arguments[1], "n").GetValue<int32_t>();
+    int attCount = arguments.size() - 2;
+    checkAttCount(attCount);
+    if (n < 2 || n > attCount) {
+        throw duckdb::BinderException("hash_if_alive layer %d must be between 2 and the number of columns (%d)", n, attCount);
+    }
+
+    auto prevSets = getCombinations(attCount, n - 1);
+    auto entry = bindSurvivors(context, key, prevSets.size());
+    auto candidates = makeCandidates(prevSets, getCombinations(attCount, n), *entry);
+    return duckdb::make_uniq<HashIfAliveBindData>(std::move(entry), std::move(candidates));
+}
+
+std::vector<lattice::AttrMask> bindAttSets(duckdb::ClientContext &context, duckdb::Expression &arg, const std::string &name, int attCount) {
+    std::vector<lattice::AttrMask> sets;
+    for (const auto& setValue : duckdb::ListValue::GetChildren(survivorCache::bindConstant(context, arg, name))) {
+        lattice::AttrMask atts = 0;
+        for (const auto& attValue : duckdb::ListValue::GetChildren(setValue)) {
+            auto att = attValue.GetValue<int32_t>();
+            if (att < 0 || att >= attCount) {
+                throw duckdb::BinderException("hash_if_alive: attribute %d in %s is not one of the %d columns", att, name, attCount);
+            }
+            atts = lattice::withAtt(atts, att);
+        }
+        sets.push_back(atts);
+    }
+    return sets;
+}
+
+// hash_if_alive(key, prev_sets, sets, col...): explicit layouts of both layers,
+// e.g. Apriori candidates generated from the previous layer's surviving sets
+duckdb::unique_ptr<duckdb::FunctionData> hashIfAliveSetsBind(duckdb::ClientContext &context, duckdb::ScalarFunction &function, duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> &arguments) {
+    auto key = survivorCache::bindConstant(context, *arguments[0], "key").ToString();
+    int attCount = arguments.size() - 3;
+    checkAttCount(attCount);
+    auto prevSets = bindAttSets(context, *arguments[1], "prev_sets", attCount);
+    auto sets = bindAttSets(context, *arguments[2], "sets", attCount);
+
+    auto entry = bindSurvivors(context, key, prevSets.size());
+    auto candidates = makeCandidates(prevSets, sets, *entry);
+    return duckdb::make_uniq<HashIfAliveBindData>(std::move(entry), std::move(candidates));
+}
+
+duckdb::unique_ptr<duckdb::FunctionLocalState> hashIfAliveInitLocal(duckdb::ExpressionState &state, const duckdb::BoundFunctionExpression &expr, duckdb::FunctionData *bindData) {
+    return duckdb::make_uniq<ProbeStats>(bindData->Cast<HashIfAliveBindData>().entry->sets.size());
+}
+
+/*
+    Hash a dictionary vector (e.g. Parquet dictionary pages or dictionary compressed
+    storage) by its codes: every dictionary entry is hashed once and rows look
+    their hash up, so values aren't decoded or hashed per row. Returns false when
+    the dictionary is larger than the chunk, where hashing rows is cheaper.
+*/
+bool hashDictionary(duckdb::Vector &input, idx_t count, std::vector<hash_t> &out) {
+    auto &codes = duckdb::DictionaryVector::SelVector(input);
+    idx_t dictSize = 0;
+    for (idx_t row = 0; row < count; row++) {
+        dictSize = std::max<idx_t>(dictSize, codes.get_index(row) + 1);
+    }
+    if (dictSize > count) {
+        return false;
+    }
+
+    auto &dictionary = duckdb::DictionaryVector::Child(input);
+    duckdb::Vector dictHashVec(duckdb::LogicalType::HASH, dictSize);
+    duckdb::VectorOperations::Hash(dictionary, dictHashVec, dictSize);
+    dictHashVec.Flatten(dictSize);
+    auto dictHashes = duckdb::FlatVector::GetData<hash_t>(dictHashVec);
+
+    duckdb::UnifiedVectorFormat dictData;
+    dictionary.ToUnifiedFormat(dictSize, dictData);
+    for (idx_t code = 0; code < dictSize; code++) {
+        if (!dictData.validity.RowIsValid(dictData.sel->get_index(code))) {
+            dictHashes[code] = 0;
+        }
+    }
+
+    out.resize(count);
+    for (idx_t row = 0; row < count; row++) {
+        out[row] = dictHashes[codes.get_index(row)];
+    }
+    return true;
+}
+
+/*
+    Hash every column once for the chunk. Matches Value::Hash() (as used by
+    hash_list) including NULLs hashing to 0.
+*/
+void hashColumn(duckdb::Vector &input, idx_t count, std::vector<hash_t> &out) {
+    if (input.GetVectorType() == duckdb::VectorType::DICTIONARY_VECTOR && hashDictionary(input, count, out)) {
+        return;
+    }
+    duckdb::Vector hashVec(duckdb::LogicalType::HASH, count);
+    duckdb::VectorOperations::Hash(input, hashVec, count);
+    hashVec.Flatten(count);
+    auto hashes = duckdb::FlatVector::GetData<hash_t>(hashVec);
+
+    duckdb::UnifiedVectorFormat inputData;
+    input.ToUnifiedFormat(count, inputData);
+
+    out.resize(count);
+    for (idx_t row = 0; row < count; row++) {
+        out[row] = inputData.validity.RowIsValid(inputData.sel->get_index(row)) ? hashes[row] : 0;
+    }
+}
+
+void hashColumns(duckdb::DataChunk &args, idx_t firstCol, std::vector<std::vector<hash_t>> &colHashes) {
+    for (idx_t col = 0; col < colHashes.size(); col++) {
+        hashColumn(args.data[firstCol + col], args.size(), colHashes[col]);
+    }
+}
+
+/*
+    hash_row(col...): the hash_list([col...]) of every row, without building a list
+    Value per row. Columns keep their own types (no common list type is needed), so
+    fixed-width columns are hashed directly by DuckDB's per-type hash, which
+    matches Value::Hash().
+*/
+void hashRowFunction(duckdb::DataChunk &args, duckdb::ExpressionState &state, duckdb::Vector &result) {
+    auto count = args.size();
+    std::vector<std::vector<hash_t>> colHashes(args.ColumnCount());
+    hashColumns(args, 0, colHashes);
+
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    auto out = duckdb::FlatVector::GetData<uint64_t>(result);
+    for (idx_t row = 0; row < count; row++) {
+        hash_t hash = 0;
+        for (const auto& hashes : colHashes) {
+            hash = hashList::combineHashes(hash, hashes[row]);
+        }
+        out[row] = hash;
+    }
+}
+
+// hash_atts(atts, col...): atts (column indexes) bound once, as hash_row's bind data
+struct HashAttsBindData : public duckdb::FunctionData {
+    lattice::AttrMask atts;
+
+    explicit HashAttsBindData(lattice::AttrMask atts) : atts(atts) {}
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<HashAttsBindData>(atts);
+    }
+
+    bool Equals(const duckdb::FunctionData &other) const override {
+        return atts == other.Cast<HashAttsBindData>().atts;
+    }
+};
+
+duckdb::unique_ptr<duckdb::FunctionData> hashAttsBind(duckdb::ClientContext &context, duckdb::ScalarFunction &function, duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> &arguments) {
+    int attCount = arguments.size() - 1;
+    checkAttCount(attCount);
+    lattice::AttrMask atts = 0;
+    for (const auto& attValue : duckdb::ListValue::GetChildren(survivorCache::bindConstant(context, *arguments[0], "atts"))) {
+        auto att = attValue.GetValue<int32_t>();
+        if (att < 0 || att >= attCount) {
+            throw duckdb::BinderException("hash_atts: attribute %d is not one of the %d columns", att, attCount);
+        }
+        atts = lattice::withAtt(atts, att);
+    }
+    return duckdb::make_uniq<HashAttsBindData>(atts);
+}
+
+/*
+    hash_atts(atts, col...): hash_row of the columns listed in atts (in column
+    order), so a query can take the hashed set as a parameter. Only those columns
+    are hashed.
+*/
+void hashAttsFunction(duckdb::DataChunk &args, duckdb::ExpressionState &state, duckdb::Vector &result) {
+    auto &bindData = state.expr.Cast<duckdb::BoundFunctionExpression>().bind_info->Cast<HashAttsBindData>();
+    auto count = args.size();
+
+    result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+    auto out = duckdb::FlatVector::GetData<uint64_t>(result);
+    for (idx_t row = 0; row < count; row++) {
+        out[row] = 0;
+    }
+    std::vector<hash_t> hashes;
+    lattice::forEachAtt(bindData.atts, [&](int att) {
+        hashColumn(args.data[1 + att], count, hashes);
+        for (idx_t row = 0; row < count; row++) {
+            out[row] = hashList::combineHashes(out[row], hashes[row]);
+        }
+    });
+}
+
+inline hash_t subsetHash(lattice::AttrMask atts, const std::vector<std::vector<hash_t>> &colHashes, idx_t row) {
+    hash_t hash = 0;
+    lattice::forEachAtt(atts, [&](int att) {
+        hash = hashList::combineHashes(hash, colHashes[att][row]);
+    });
+    return hash;
+}
+
+/*
+    Probe a chunk's rows against the survivors of every candidate's subsets and
+    call emit(candidate, row, hash) for each row alive for a candidate.
+*/
+template <class EMIT>
+void probeChunk(const std::vector<std::vector<hash_t>> &colHashes, idx_t count, const survivorCache::SurvivorEntry &entry,
+                const std::vector<Candidate> &candidates, ProbeStats &stats, EMIT &&emit) {
+    auto &survivors = entry.sets;
+
+    // Prefix hashes and their surviving rows, shared by consecutive candidates
+    idx_t prefixOffset = duckdb::DConstants::INVALID_INDEX;
+    std::vector<hash_t> prefixHashes(count);
+    std::vector<idx_t> prefixAlive;
+    std::vector<idx_t> alive;
+    std::vector<idx_t> probeOrder;
+    std::vector<hash_t> probeHashes(count);
+
+    for (idx_t c = 0; c < candidates.size(); c++) {
+        auto &candidate = candidates[c];
+        auto &prefix = candidate.subsets[0];
+        if (candidate.dead) {
+            continue;
+        }
+
+        // The prefix is probed first: its result is reused by the following candidates
+        if (prefix.second != prefixOffset) {
+            prefixOffset = prefix.second;
+            prefixAlive.resize(count);
+            for (idx_t row = 0; row < count; row++) {
+                prefixHashes[row] = subsetHash(prefix.first, colHashes, row);
+                probeHashes[row] = prefixHashes[row];
+                prefixAlive[row] = row;
+            }
+            auto &validVals = survivors[prefixOffset];
+            prefixAlive.resize(eytzinger::filterRows(validVals.data(), validVals.size(), probeHashes.data(), prefixAlive.data(), count));
+            stats.probed[prefixOffset] += count;
+            stats.passed[prefixOffset] += prefixAlive.size();
+        }
+
+        // Remaining subsets in ascending order of estimated pass rate
+        probeOrder.clear();
+        for (idx_t s = 1; s < candidate.subsets.size(); s++) {
+            probeOrder.push_back(s);
+        }
+        std::sort(probeOrder.begin(), probeOrder.end(), [&](idx_t a, idx_t b) {
+            return stats.passRate(entry, candidate.subsets[a].second) <
+                   stats.passRate(entry, candidate.subsets[b].second);
+        });
+
+        // Narrow the surviving rows subset by subset
+        alive = prefixAlive;
+        for (idx_t i = 0; i < probeOrder.size() && !alive.empty(); i++) {
+            auto &subset = candidate.subsets[probeOrder[i]];
+            auto &validVals = survivors[subset.second];
+            for (idx_t r = 0; r < alive.size(); r++) {
+                probeHashes[r] = subsetHash(subset.first, colHashes, alive[r]);
+            }
+            auto aliveCount = eytzinger::filterRows(validVals.data(), validVals.size(), probeHashes.data(), alive.data(), alive.size());
+            stats.probed[subset.second] += alive.size();
+            stats.passed[subset.second] += aliveCount;
+            alive.resize(aliveCount);
+        }
+
+        // Candidate hash extends the prefix hash by the last att.
+        auto &lastHashes = colHashes[lattice::highestAtt(candidate.atts)];
+        for (const auto& row : alive) {
+            emit(c, row, hashList::combineHashes(prefixHashes[row], lastHashes[row]));
+        }
+    }
+}
+
+void hashIfAliveFunction(duckdb::DataChunk &args, duckdb::ExpressionState &state, duckdb::Vector &result) {
+    auto &bindData = state.expr.Cast<duckdb::BoundFunctionExpression>().bind_info->Cast<HashIfAliveBindData>();
+    auto &candidates = *bindData.candidates;
+    auto &stats = duckdb::ExecuteFunctionState::GetFunctionState(state)->Cast<ProbeStats>();
+    auto count = args.size();
+    auto setCount = candidates.size();
+
+    // Columns follow the key and one (n) or two (prev_sets, sets) layout arguments
+    idx_t firstCol = args.data[1].GetType().id() == duckdb::LogicalTypeId::LIST ? 3 : 2;
+    std::vector<std::vector<hash_t>> colHashes(args.ColumnCount() - firstCol);
+    hashColumns(args, firstCol, colHashes);
+
+    // Result: one list of setCount entries per row, all NULL until proven alive
+    auto listOffset = duckdb::ListVector::GetListSize(result);
+    duckdb::ListVector::Reserve(result, listOffset + count * setCount);
+    auto listData = duckdb::FlatVector::GetData<duckdb::list_entry_t>(result);
+    auto &child = duckdb::ListVector::GetEntry(result);
+    auto childData = duckdb::FlatVector::GetData<hash_t>(child);
+    auto &childValidity = duckdb::FlatVector::Validity(child);
+    for (idx_t row = 0; row < count; row++) {
+        listData[row] = duckdb::list_entry_t(listOffset + row * setCount, setCount);
+        for (idx_t i = 0; i < setCount; i++) {
+            childValidity.SetInvalid(listOffset + row * setCount + i);
+        }
+    }
+
+    probeChunk(colHashes, count, *bindData.entry, candidates, stats, [&](idx_t c, idx_t row, hash_t hash) {
+        auto idx = listOffset + row * setCount + c;
+        childData[idx] = hash;
+        childValidity.SetValid(idx);
+    });
+
+    duckdb::ListVector::SetListSize(result, listOffset + count * setCount);
+    if (args.AllConstant()) {
+        result.SetVectorType(duckdb::VectorType::CONSTANT_VECTOR);
+    }
+}
+
+} // namespace hashIfAlive
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+/*
+Attribute sets as bitmasks: bit i is set when attribute (column) i is in the set.
+AttrMask covers up to 64 attributes in a single word, so union, intersection,
+subset tests and hashing are single instructions. WideAttrMask<WORDS> is the same
+for WORDS * 64 attributes, with helpers of the same names.
+
+Sets are compared lexicographically by their sorted attributes (lexLess), which is
+the order layers are laid out in.
+*/
+
+namespace lattice {
+
+using AttrMask = uint64_t;
+
+inline int popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word; word &= word - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Index of the lowest set bit, word must be non-zero
+inline int lowestBit64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Index of the highest set bit, word must be non-zero
+inline int highestBit64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(word);
+#else
+    int bit = 0;
+    while (word >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+inline AttrMask attBit(int att) {
+    return AttrMask(1) << att;
+}
+
+inline int attCount(AttrMask mask) {
+    return popcount64(mask);
+}
+
+inline bool hasAtt(AttrMask mask, int att) {
+    return (mask >> att) & 1;
+}
+
+inline AttrMask withAtt(AttrMask mask, int att) {
+    return mask | attBit(att);
+}
+
+inline AttrMask withoutAtt(AttrMask mask, int att) {
+    return mask & ~attBit(att);
+}
+
+inline bool isSubset(AttrMask sub, AttrMask mask) {
+    return (sub & ~mask) == 0;
+}
+
+inline int lowestAtt(AttrMask mask) {
+    return lowestBit64(mask);
+}
+
+inline int highestAtt(AttrMask mask) {
+    return highestBit64(mask);
+}
+
+// Call fn(att) for every attribute in ascending order
+template <class FN>
+inline void forEachAtt(AttrMask mask, FN &&fn) {
+    for (; mask; mask &= mask - 1) {
+        fn(lowestBit64(mask));
+    }
+}
+
+/*
+    Lexicographic order of the sorted attribute lists for sets of equal size:
+    the set holding the lowest attribute they differ in comes first.
+*/
+inline bool lexLess(AttrMask a, AttrMask b) {
+    AttrMask diff = a ^ b;
+    return diff && (a & diff & (~diff + 1));
+}
+
+/*
+    Attribute sets of up to WORDS * 64 attributes, for tables wider than one
+    word. Its helpers are hidden friends, found by argument-dependent lookup
+    (e.g. attCount(mask) in generic code), so lattice::lexLess and the other
+    qualified names still denote the single-word functions alone and can be
+    passed around as plain function pointers.
+*/
+template <size_t WORDS>
+struct WideAttrMask {
+    std::array<uint64_t, WORDS> words{};
+
+    WideAttrMask operator|(const WideAttrMask &other) const {
+        WideAttrMask out;
+        for (size_t w = 0; w < WORDS; w++) {
+            out.words[w] = words[w] | other.words[w];
+        }
+        return out;
+    }
+
+    WideAttrMask operator&(const WideAttrMask &other) const {
+        WideAttrMask out;
+        for (size_t w = 0; w < WORDS; w++) {
+            out.words[w] = words[w] & other.words[w];
+        }
+        return out;
+    }
+
+    WideAttrMask operator^(const WideAttrMask &other) const {
+        WideAttrMask out;
+        for (size_t w = 0; w < WORDS; w++) {
+            out.words[w] = words[w] ^ other.words[w];
+        }
+        return out;
+    }
+
+    WideAttrMask operator~() const {
+        WideAttrMask out;
+        for (size_t w = 0; w < WORDS; w++) {
+            out.words[w] = ~words[w];
+        }
+        return out;
+    }
+
+    bool operator==(const WideAttrMask &other) const {
+        return words == other.words;
+    }
+
+    bool operator!=(const WideAttrMask &other) const {
+        return words != other.words;
+    }
+
+    bool empty() const {
+        for (const auto& word : words) {
+            if (word) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend int attCount(const WideAttrMask &mask) {
+        int count = 0;
+        for (const auto& word : mask.words) {
+            count += popcount64(word);
+        }
+        return count;
+    }
+
+    friend bool hasAtt(const WideAttrMask &mask, int att) {
+        return (mask.words[att / 64] >> (att % 64)) & 1;
+    }
+
+    friend WideAttrMask withAtt(WideAttrMask mask, int att) {
+        mask.words[att / 64] |= uint64_t(1) << (att % 64);
+        return mask;
+    }
+
+    friend WideAttrMask withoutAtt(WideAttrMask mask, int att) {
+        mask.words[att / 64] &= ~(uint64_t(1) << (att % 64));
+        return mask;
+    }
+
+    friend bool isSubset(const WideAttrMask &sub, const WideAttrMask &mask) {
+        for (size_t w = 0; w < WORDS; w++) {
+            if (sub.words[w] & ~mask.words[w]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Lowest attribute, mask must be non-empty
+    friend int lowestAtt(const WideAttrMask &mask) {
+        size_t w = 0;
+        while (!mask.words[w]) {
+            w++;
+        }
+        return w * 64 + lowestBit64(mask.words[w]);
+    }
+
+    // Highest attribute, mask must be non-empty
+    friend int highestAtt(const WideAttrMask &mask) {
+        size_t w = WORDS - 1;
+        while (!mask.words[w]) {
+            w--;
+        }
+        return w * 64 + highestBit64(mask.words[w]);
+    }
+
+    template <class FN>
+    friend void forEachAtt(const WideAttrMask &mask, FN &&fn) {
+        for (size_t w = 0; w < WORDS; w++) {
+            for (uint64_t word = mask.words[w]; word; word &= word - 1) {
+                fn(w * 64 + lowestBit64(word));
+            }
+        }
+    }
+
+    friend bool lexLess(const WideAttrMask &a, const WideAttrMask &b) {
+        for (size_t w = 0; w < WORDS; w++) {
+            uint64_t diff = a.words[w] ^ b.words[w];
+            if (diff) {
+                return a.words[w] & diff & (~diff + 1);
+            }
+        }
+        return false;
+    }
+};
+
+// The single attribute att as a WORDS-word mask
+template <size_t WORDS>
+inline WideAttrMask<WORDS> wideAttBit(int att) {
+    WideAttrMask<WORDS> mask;
+    mask.words[att / 64] = uint64_t(1) << (att % 64);
+    return mask;
+}
+
+// Conversions from and to sorted attribute lists (e.g. SQL INTEGER[] values)
+template <class MASK = AttrMask>
+inline MASK fromAtts(const std::vector<int> &atts) {
+    MASK mask{};
+    for (const auto& att : atts) {
+        mask = withAtt(mask, att);
+    }
+    return mask;
+}
+
+template <class MASK>
+inline std::vector<int> toAtts(const MASK &mask) {
+    std::vector<int> atts;
+    forEachAtt(mask, [&](int att) {
+        atts.push_back(att);
+    });
+    return atts;
+}
+
+} // namespace lattice
+
+namespace std {
+
+template <size_t WORDS>
+struct hash<lattice::WideAttrMask<WORDS>> {
+    size_t operator()(const lattice::WideAttrMask<WORDS> &mask) const {
+        uint64_t seed = 0;
+        for (const auto& word : mask.words) {
+            seed ^= word + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+};
+
+} // namespace std
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*
+A mined dataset encoded as one 64-bit hash per cell, stored column by column so it
+can be memory mapped and scanned in place on later runs (MappedEncodedDataset)
+instead of re-reading and re-parsing the source:
+
+    DatasetHeader | uint64_t[rowCount] for column 0 | ... | column[columnCount-1]
+
+in host byte order. The header carries the DatasetKey of the source it was encoded
+from, so a cache is only reused while the source (and how it was ingested) is
+unchanged.
+*/
+
+namespace lattice {
+
+/*
+    Identifies a source file as it was ingested: its size and modification time, a
+    fingerprint of its content and a hash of the ingest options (which columns,
+    read as which types). The fingerprint hashes the first, middle and last 64KB
+    rather than the whole file, so checking a key stays cheap on large files.
+*/
+struct DatasetKey {
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    uint64_t fingerprint = 0;
+    uint64_t optionsHash = 0;
+
+    bool operator==(const DatasetKey &other) const {
+        return sourceSize == other.sourceSize && sourceMtime == other.sourceMtime &&
+               fingerprint == other.fingerprint && optionsHash == other.optionsHash;
+    }
+};
+
+struct DatasetHeader {
+    char magic[8];
+    uint64_t version;
+    DatasetKey key;
+    uint64_t rowCount;
+    uint64_t columnCount;
+};
+
+const char DATASET_MAGIC[8] = {'Q', 'E', 'N', 'C', 'O', 'D', 'E', 'D'};
+const uint64_t DATASET_VERSION = 1;
+const uint64_t FINGERPRINT_BLOCK = 1 << 16;
+
+// FNV-1a, continuing from hash
+inline uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL) {
+    auto bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Key of the file at path ingested with options; throws if it can't be read
+inline DatasetKey datasetKey(const std::string &path, const std::string &options) {
+    DatasetKey key;
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Could not open '" + path + "'");
+    }
+#ifndef _WIN32
+    struct stat info;
+    if (::fstat(::fileno(file), &info) == 0) {
+        key.sourceMtime = info.st_mtime;
+    }
+#endif
+    std::fseek(file, 0, SEEK_END);
+    key.sourceSize = std::ftell(file);
+
+    std::vector<char> block(FINGERPRINT_BLOCK);
+    uint64_t hash = fnv1a(&key.sourceSize, sizeof(key.sourceSize));
+    uint64_t middle = key.sourceSize / 2;
+    for (uint64_t offset : {(uint64_t) 0, middle - std::min(middle, FINGERPRINT_BLOCK / 2),
+                            key.sourceSize - std::min(key.sourceSize, FINGERPRINT_BLOCK)}) {
+        std::fseek(file, offset, SEEK_SET);
+        size_t read = std::fread(block.data(), 1, block.size(), file);
+        hash = fnv1a(block.data(), read, hash);
+    }
+    std::fclose(file);
+
+    key.fingerprint = hash;
+    key.optionsHash = fnv1a(options.data(), options.size());
+    return key;
+}
+
+/*
+    Writes an encoded dataset column by column (every column has rowCount
+    hashes). The file is written under a temporary name and only renamed into
+    place by finish(), so an interrupted write never leaves a cache that looks
+    valid.
+*/
+class EncodedDatasetWriter {
+private:
+    std::string path;
+    std::string tmpPath;
+    FILE *file = nullptr;
+    uint64_t expected;
+    uint64_t written = 0;
+
+public:
+    EncodedDatasetWriter(const std::string &path, const DatasetKey &key, uint64_t rowCount, uint64_t columnCount) :
+        path(path), tmpPath(path + ".tmp"), expected(rowCount * columnCount) {
+        DatasetHeader header;
+        std::memcpy(header.magic, DATASET_MAGIC, sizeof(DATASET_MAGIC));
+        header.version = DATASET_VERSION;
+        header.key = key;
+        header.rowCount = rowCount;
+        header.columnCount = columnCount;
+
+        file = std::fopen(tmpPath.c_str(), "wb");
+        if (!file || std::fwrite(&header, sizeof(header), 1, file) != 1) {
+            discard();
+            throw std::runtime_error("Could not open encoded dataset '" + path + "' for writing");
+        }
+    }
+
+    EncodedDatasetWriter(const EncodedDatasetWriter&) = delete;
+    EncodedDatasetWriter& operator=(const EncodedDatasetWriter&) = delete;
+
+    ~EncodedDatasetWriter() {
+        discard();
+    }
+
+    // Append the next count hashes (columns follow each other)
+    void append(const uint64_t *hashes, uint64_t count) {
+        if (written + count > expected || std::fwrite(hashes, sizeof(uint64_t), count, file) != count) {
+            discard();
+            throw std::runtime_error("Failed to write encoded dataset '" + path + "'");
+        }
+        written += count;
+    }
+
+    void finish() {
+        bool complete = written == expected;
+        complete = std::fclose(file) == 0 && complete;
+        file = nullptr;
+        if (!complete || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("Failed to write encoded dataset '" + path + "'");
+        }
+    }
+
+    void discard() {
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+            std::remove(tmpPath.c_str());
+        }
+    }
+};
+
+/*
+    Read-only view of an encoded dataset. The file is mapped (or read, where mmap
+    isn't available) once and its columns are scanned in place.
+*/
+class MappedEncodedDataset {
+private:
+    const DatasetHeader *header = nullptr;
+    const uint64_t *columns = nullptr;
+    void *data = nullptr;
+    size_t dataSize = 0;
+    std::vector<char> buffer;
+
+public:
+    explicit MappedEncodedDataset(const std::string &path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open encoded dataset '" + path + "'");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not stat encoded dataset '" + path + "'");
+        }
+        dataSize = info.st_size;
+        if (dataSize >= sizeof(DatasetHeader)) {
+            data = ::mmap(nullptr, dataSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            data = nullptr;
+        }
+#else
+        FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            throw std::runtime_error("Could not open encoded dataset '" + path + "'");
+        }
+        char chunk[1 << 16];
+        size_t read;
+        while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            buffer.insert(buffer.end(), chunk, chunk + read);
+        }
+        std::fclose(file);
+        dataSize = buffer.size();
+        data = dataSize >= sizeof(DatasetHeader) ? buffer.data() : nullptr;
+#endif
+
+        // (the cell count is checked by division, so huge counts can't overflow)
+        header = (const DatasetHeader *)data;
+        if (!header || std::memcmp(header->magic, DATASET_MAGIC, sizeof(DATASET_MAGIC)) != 0 ||
+            header->version != DATASET_VERSION ||
+            (dataSize - sizeof(DatasetHeader)) % sizeof(uint64_t) != 0 ||
+            (header->rowCount == 0 ? dataSize != sizeof(DatasetHeader) :
+             header->columnCount != (dataSize - sizeof(DatasetHeader)) / sizeof(uint64_t) / header->rowCount ||
+             (dataSize - sizeof(DatasetHeader)) / sizeof(uint64_t) % header->rowCount != 0)) {
+            release();
+            throw std::runtime_error("'" + path + "' is not a valid encoded dataset");
+        }
+        columns = (const uint64_t *)(header + 1);
+    }
+
+    MappedEncodedDataset(const MappedEncodedDataset&) = delete;
+    MappedEncodedDataset& operator=(const MappedEncodedDataset&) = delete;
+
+    ~MappedEncodedDataset() {
+        release();
+    }
+
+    void release() {
+#ifndef _WIN32
+        if (data) {
+            ::munmap(data, dataSize);
+        }
+#endif
+        data = nullptr;
+        header = nullptr;
+        columns = nullptr;
+    }
+
+    const DatasetKey& key() const {
+        return header->key;
+    }
+
+    uint64_t rowCount() const {
+        return header->rowCount;
+    }
+
+    uint64_t columnCount() const {
+        return header->columnCount;
+    }
+
+    // Hashes of column col, rowCount() of them
+    const uint64_t* column(uint64_t col) const {
+        return columns + col * header->rowCount;
+    }
+};
+
+} // namespace lattice
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "attr_mask.hpp"
+
+/*
+Entropies of mined attribute sets, kept in a flat open-addressing hash table keyed
+by AttrMask. The file format is the table itself, so a saved store can be memory
+mapped and probed in place (MappedEntropyStore) without parsing:
+
+    StoreHeader | EntropyRecord[capacity]
+
+in host byte order. Empty slots have mask 0 (the empty set is never stored).
+*/
+
+namespace lattice {
+
+struct EntropyRecord {
+    AttrMask mask;
+    double entropy;
+    // Distinct values of the att. set in the relation
+    uint64_t distinctCount;
+};
+
+struct StoreHeader {
+    char magic[8];
+    uint64_t version;
+    uint64_t capacity;
+    uint64_t size;
+    // Tuples in the relation the entropies were mined from
+    uint64_t tupleCount;
+};
+
+const char STORE_MAGIC[8] = {'Q', 'E', 'N', 'T', 'R', 'O', 'P', 'Y'};
+const uint64_t STORE_VERSION = 1;
+
+inline uint64_t slotOf(AttrMask mask, uint64_t capacity) {
+    // Fibonacci hashing, capacity is a power of two
+    return (mask * 0x9E3779B97F4A7C15ULL) >> (64 - highestBit64(capacity)) & (capacity - 1);
+}
+
+// Linear probe for mask, returns nullptr if it isn't stored (at most capacity probes)
+inline const EntropyRecord* findRecord(const EntropyRecord *slots, uint64_t capacity, AttrMask mask) {
+    uint64_t slot = slotOf(mask, capacity);
+    for (uint64_t probe = 0; probe < capacity; probe++, slot = (slot + 1) & (capacity - 1)) {
+        if (slots[slot].mask == mask) {
+            return &slots[slot];
+        }
+        if (slots[slot].mask == 0) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+class EntropyStore {
+private:
+    std::vector<EntropyRecord> slots;
+    uint64_t count = 0;
+    uint64_t tupleCount = 0;
+
+    void grow() {
+        std::vector<EntropyRecord> old = std::move(slots);
+        slots.assign(old.size() * 2, EntropyRecord{0, 0.0, 0});
+        count = 0;
+        for (const auto& record : old) {
+            if (record.mask != 0) {
+                put(record.mask, record.entropy, record.distinctCount);
+            }
+        }
+    }
+
+public:
+    explicit EntropyStore(uint64_t capacity = 1024) {
+        uint64_t size = 16;
+        while (size < capacity) {
+            size *= 2;
+        }
+        slots.assign(size, EntropyRecord{0, 0.0, 0});
+    }
+
+    // Insert or overwrite the entropy of mask
+    void put(AttrMask mask, double entropy, uint64_t distinctCount) {
+        // Keep the load factor at most 1/2 so probes stay short
+        if (2 * (count + 1) > slots.size()) {
+            grow();
+        }
+        for (uint64_t slot = slotOf(mask, slots.size());; slot = (slot + 1) & (slots.size() - 1)) {
+            if (slots[slot].mask == 0 || slots[slot].mask == mask) {
+                count += slots[slot].mask == 0;
+                slots[slot] = {mask, entropy, distinctCount};
+                return;
+            }
+        }
+    }
+
+    const EntropyRecord* find(AttrMask mask) const {
+        return findRecord(slots.data(), slots.size(), mask);
+    }
+
+    uint64_t size() const {
+        return count;
+    }
+
+    void setTupleCount(uint64_t tuples) {
+        tupleCount = tuples;
+    }
+
+    uint64_t getTupleCount() const {
+        return tupleCount;
+    }
+
+    void clear() {
+        std::fill(slots.begin(), slots.end(), EntropyRecord{0, 0.0, 0});
+        count = 0;
+    }
+
+    template <class FN>
+    void forEach(FN &&fn) const {
+        for (const auto& record : slots) {
+            if (record.mask != 0) {
+                fn(record);
+            }
+        }
+    }
+
+    /*
+        Write the store to path. It is written under a temporary name and renamed
+        into place, so a run killed while checkpointing keeps the previous store
+        rather than a truncated one.
+    */
+    void save(const std::string &path) const {
+        StoreHeader header;
+        std::memcpy(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+        header.version = STORE_VERSION;
+        header.capacity = slots.size();
+        header.size = count;
+        header.tupleCount = tupleCount;
+
+        std::string tmpPath = path + ".tmp";
+        FILE *file = std::fopen(tmpPath.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("Could not open entropy store '" + path + "' for writing");
+        }
+        bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                       std::fwrite(slots.data(), sizeof(EntropyRecord), slots.size(), file) == slots.size();
+        written = std::fclose(file) == 0 && written;
+        if (!written || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("Failed to write entropy store '" + path + "'");
+        }
+    }
+};
+
+/*
+    Read-only view of a saved store. The file is mapped (or read, where mmap isn't
+    available) once and looked up in place.
+*/
+class MappedEntropyStore {
+private:
+    const StoreHeader *header = nullptr;
+    const EntropyRecord *slots = nullptr;
+    void *data = nullptr;
+    size_t dataSize = 0;
+    std::vector<char> buffer;
+
+public:
+    explicit MappedEntropyStore(const std::string &path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open entropy store '" + path + "'");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not stat entropy store '" + path + "'");
+        }
+        dataSize = info.st_size;
+        if (dataSize >= sizeof(StoreHeader)) {
+            data = ::mmap(nullptr, dataSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            data = nullptr;
+        }
+#else
+        FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            throw std::runtime_error("Could not open entropy store '" + path + "'");
+        }
+        char chunk[1 << 16];
+        size_t read;
+        while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            buffer.insert(buffer.end(), chunk, chunk + read);
+        }
+        std::fclose(file);
+        dataSize = buffer.size();
+        data = dataSize >= sizeof(StoreHeader) ? buffer.data() : nullptr;
+#endif
+
+        // Every probe sequence must end at an empty slot, so a full table is rejected;
+        // the slot count is checked by division, so a huge capacity can't overflow
+        header = (const StoreHeader *)data;
+        if (!header || std::memcmp(header->magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 ||
+            header->version != STORE_VERSION ||
+            header->capacity < 2 || (header->capacity & (header->capacity - 1)) != 0 ||
+            header->size >= header->capacity ||
+            (dataSize - sizeof(StoreHeader)) % sizeof(EntropyRecord) != 0 ||
+            (dataSize - sizeof(StoreHeader)) / sizeof(EntropyRecord) != header->capacity) {
+            release();
+            throw std::runtime_error("'" + path + "' is not a valid entropy store");
+        }
+        slots = (const EntropyRecord *)(header + 1);
+    }
+
+    MappedEntropyStore(const MappedEntropyStore&) = delete;
+    MappedEntropyStore& operator=(const MappedEntropyStore&) = delete;
+
+    ~MappedEntropyStore() {
+        release();
+    }
+
+    void release() {
+#ifndef _WIN32
+        if (data) {
+            ::munmap(data, dataSize);
+        }
+#endif
+        data = nullptr;
+        header = nullptr;
+        slots = nullptr;
+    }
+
+    const EntropyRecord* find(AttrMask mask) const {
+        return findRecord(slots, header->capacity, mask);
+    }
+
+    uint64_t size() const {
+        return header->size;
+    }
+
+    uint64_t getTupleCount() const {
+        return header->tupleCount;
+    }
+
+    template <class FN>
+    void forEach(FN &&fn) const {
+        for (uint64_t slot = 0; slot < header->capacity; slot++) {
+            if (slots[slot].mask != 0) {
+                fn(slots[slot]);
+            }
+        }
+    }
+};
+
+} // namespace lattice
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_set>
+
+#include "attr_mask.hpp"
+
+/*
+Attribute-set lattice helpers shared by the SchemaMiner driver and the extension,
+so both sides lay layers out in the same order.
+
+Att. sets are numbered by their colex rank (combinatorial number system): the
+k-set {a0 < a1 < ... < ak-1} has rank C(a0, 1) + C(a1, 2) + ... + C(ak-1, k),
+so the k-sets of the first m attributes are exactly ranks 0 to C(m, k) - 1 and a
+set's position in a layer is found with O(k) arithmetic instead of a map lookup.
+*/
+
+namespace lattice {
+
+// Ranks fit in 64 bits (C(64, 32) < 2^61) up to this many attributes, which is
+// also what a single-word AttrMask holds
+const int MAX_ATTRIBUTES = 64;
+
+struct BinomialTable {
+    uint64_t values[MAX_ATTRIBUTES + 1][MAX_ATTRIBUTES + 1];
+
+    constexpr BinomialTable() : values() {
+        for (int n = 0; n <= MAX_ATTRIBUTES; n++) {
+            values[n][0] = 1;
+            for (int k = 1; k <= n; k++) {
+                values[n][k] = values[n - 1][k - 1] + (k < n ? values[n - 1][k] : 0);
+            }
+        }
+    }
+};
+
+inline constexpr BinomialTable BINOMIALS{};
+
+// C(n, k), 0 when k is out of range
+inline constexpr uint64_t binomial(int n, int k) {
+    return k < 0 || k > n ? 0 : BINOMIALS.values[n][k];
+}
+
+inline uint64_t colexRank(AttrMask atts) {
+    uint64_t rank = 0;
+    int i = 1;
+    forEachAtt(atts, [&](int att) {
+        rank += binomial(att, i++);
+    });
+    return rank;
+}
+
+/*
+    The k-set of the given colex rank. Attributes are picked greedily from the
+    largest down: ak-1 is the largest a with C(a, k) <= rank, and so on.
+*/
+inline AttrMask colexUnrank(uint64_t rank, int k) {
+    AttrMask atts = 0;
+    int att = MAX_ATTRIBUTES;
+    for (int i = k; i > 0; i--) {
+        while (binomial(att, i) > rank) {
+            att--;
+        }
+        atts = withAtt(atts, att);
+        rank -= binomial(att, i);
+    }
+    return atts;
+}
+
+/*
+    ranks[d] = colex rank of atts without its d-th (ascending) attribute, in O(k)
+    for all subsets. Attributes before d keep their place in the sum and those
+    after it move down one position, i.e. C(a, j + 1) becomes C(a, j).
+*/
+inline std::vector<uint64_t> subsetRanks(AttrMask atts) {
+    auto list = toAtts(atts);
+    std::vector<uint64_t> ranks(list.size());
+    uint64_t before = 0;
+    for (size_t d = 0; d < list.size(); d++) {
+        ranks[d] = before;
+        before += binomial(list[d], d + 1);
+    }
+    uint64_t after = 0;
+    for (size_t d = list.size(); d-- > 0;) {
+        ranks[d] += after;
+        after += binomial(list[d], d);
+    }
+    return ranks;
+}
+
+/*
+    Position of each att. set in a layer, addressed by colex rank. Positions are
+    stored densely by rank unless the layer is too sparse for that (Apriori
+    pruned most of a large layer), in which case ranks are binary searched.
+*/
+class LayerIndex {
+private:
+    static const uint64_t DENSE_LIMIT = 1 << 22;
+
+    std::vector<int64_t> dense;
+    std::vector<std::pair<uint64_t, int64_t>> sparse;
+
+public:
+    explicit LayerIndex(const std::vector<AttrMask>& sets) {
+        uint64_t rankCount = 0;
+        for (const auto& atts : sets) {
+            rankCount = std::max(rankCount, colexRank(atts) + 1);
+        }
+
+        if (rankCount <= DENSE_LIMIT) {
+            dense.assign(rankCount, -1);
+            for (size_t i = 0; i < sets.size(); i++) {
+                dense[colexRank(sets[i])] = i;
+            }
+        } else {
+            for (size_t i = 0; i < sets.size(); i++) {
+                sparse.emplace_back(colexRank(sets[i]), i);
+            }
+            std::sort(sparse.begin(), sparse.end());
+        }
+    }
+
+    // Position of the set with the given rank, -1 if it isn't in the layer
+    int64_t findRank(uint64_t rank) const {
+        if (sparse.empty()) {
+            return rank < dense.size() ? dense[rank] : -1;
+        }
+        auto it = std::lower_bound(sparse.begin(), sparse.end(), std::make_pair(rank, (int64_t) -1));
+        return it != sparse.end() && it->first == rank ? it->second : -1;
+    }
+
+    int64_t find(AttrMask atts) const {
+        return findRank(colexRank(atts));
+    }
+};
+
+/*
+    Apriori candidate generation: join surviving (n-1)-sets that share their first
+    n-2 attributes and keep the n-sets whose every (n-1)-subset survived. survivors
+    must be in lexicographic order; candidates are returned in lexicographic order.
+*/
+inline std::vector<AttrMask> aprioriCandidates(const std::vector<AttrMask>& survivors) {
+    std::unordered_set<AttrMask> lookup(survivors.begin(), survivors.end());
+    std::vector<AttrMask> candidates;
+
+    for (size_t i = 0; i < survivors.size(); i++) {
+        auto set1 = survivors[i];
+        auto prefix = withoutAtt(set1, highestAtt(set1));
+        for (size_t j = i + 1; j < survivors.size(); j++) {
+            auto set2 = survivors[j];
+
+            // Sets sharing a prefix are adjacent, so stop at the first mismatch
+            if (withoutAtt(set2, highestAtt(set2)) != prefix) {
+                break;
+            }
+
+            AttrMask candidate = set1 | set2;
+
+            // set1 and set2 are the subsets without the last two atts., check the rest
+            bool isValid = true;
+            forEachAtt(prefix, [&](int att) {
+                isValid = isValid && lookup.count(withoutAtt(candidate, att));
+            });
+            if (isValid) {
+                candidates.push_back(candidate);
+            }
+        }
+    }
+    return candidates;
+}
+
+/*
+    Split a layer into consecutive batches whose estimated state sizes (costs, in
+    bytes) add up to at most budget, so each batch can be counted in its own pass.
+    A set over budget on its own gets a batch to itself; budget 0 means no limit.
+    With minBatches > 1 the budget is lowered so the layer splits into about that
+    many batches (e.g. to run them concurrently).
+    Batch b covers sets [bounds[b], bounds[b + 1]).
+*/
+inline std::vector<size_t> batchBounds(const std::vector<uint64_t>& costs, uint64_t budget, size_t minBatches = 1) {
+    if (minBatches > 1) {
+        uint64_t total = 0;
+        for (const auto& cost : costs) {
+            total += cost;
+        }
+        uint64_t share = std::max<uint64_t>((total + minBatches - 1) / minBatches, 1);
+        budget = budget == 0 ? share : std::min(budget, share);
+    }
+
+    std::vector<size_t> bounds = {0};
+    uint64_t batchCost = 0;
+    for (size_t i = 0; i < costs.size(); i++) {
+        if (budget > 0 && i > bounds.back() && batchCost + costs[i] > budget) {
+            bounds.push_back(i);
+            batchCost = 0;
+        }
+        batchCost += costs[i];
+    }
+    bounds.push_back(costs.size());
+    return bounds;
+}
+
+} // namespace lattice
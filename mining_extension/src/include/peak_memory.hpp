@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace lattice {
+
+/*
+    Peak resident set size of the process in bytes (0 where unknown). Count tables
+    live outside DuckDB's buffer manager, so this is what a memory budget must
+    be checked against. Shared by the driver and mine_entropies, which run in
+    the same process.
+*/
+inline uint64_t peakMemoryBytes() {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return (uint64_t) usage.ru_maxrss * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+} // namespace lattice
@@ -6,28 +6,12 @@
 #include <iostream>
 #include <chrono>
 
+#include "lattice.hpp"
+
 namespace lift_exact {
 
 using hash_t = uint64_t;
 
-struct VectorHash {
-    hash_t operator()(const std::unordered_set<int>& s) const {
-        hash_t seed = 0;
-        for (const auto& elem : s) {
-            seed ^= std::hash<int>()(elem) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        }
-        return seed;
-    }
-
-    hash_t operator()(const std::set<int>& s) const {
-        hash_t seed = 0;
-        for (const auto& elem : s) {
-            seed ^= std::hash<int>()(elem) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        }
-        return seed;
-    }
-};
-
 struct DuckDBVectorHash {
     hash_t operator()(const duckdb::vector<duckdb::Value>& v) const {
         hash_t seed = 0;
@@ -42,7 +26,7 @@ class SetPruner {
 private:
     int attCount = 0;
     bool setsInitialised = false;
-    std::vector<std::set<int>> validSets = {};
+    std::vector<lattice::AttrMask> validSets = {};
 
 public:
     static SetPruner& GetInstance() {
@@ -58,49 +42,13 @@ public:
     void setInitialCombinations(const int attCount) {
         this->attCount = attCount;
         for (int i = 0; i < attCount; i++) {
-            validSets.emplace_back(std::set<int>{i});
+            validSets.push_back(lattice::attBit(i));
         }
     }
 
     void generateCombinations() {
-        std::vector<std::set<int>> nextSets;
-        size_t n = validSets.empty() ? 0 : validSets[0].size();
-
-        // Use hash set for quick lookups
-        std::unordered_set<std::set<int>, VectorHash> validSetLookup(validSets.begin(), validSets.end());
-
-        // Iterate over all pairs of valid sets
-        for (size_t i = 0; i < validSets.size(); ++i) {
-            // For the first (n-1) elements to be equal, the sets must be within [attCount] of each other in the set vector
-            int upperLimit = std::min(i + attCount, validSets.size());
-            for (size_t j = i + 1; j < upperLimit; ++j) {
-                auto& set1 = validSets[i];
-                auto& set2 = validSets[j];
-
-                // Check if first (n-1) elements match (set logic)
-                if (std::includes(set1.begin(), std::prev(set1.end()), set2.begin(), std::prev(set2.end())) ||
-                    std::includes(set2.begin(), std::prev(set2.end()), set1.begin(), std::prev(set1.end()))) {
-
-                    std::set<int> candidate = set1;
-                    candidate.insert(*set2.rbegin());
-
-                    // Check if all size n subsets are valid
-                    bool isValid = true;
-                    for (const int& elem : candidate) {
-                        std::set<int> subset = candidate;
-                        subset.erase(elem);
-                        if (validSetLookup.find(subset) == validSetLookup.end()) {
-                            isValid = false;
-                            break;
-                        }
-                    }
-                    if (isValid) {
-                        nextSets.push_back(std::move(candidate));
-                    }
-                }
-            }
-        }
-        validSets = std::move(nextSets);
+        // validSets stays in lexicographic order, as the Apriori join expects
+        validSets = lattice::aprioriCandidates(validSets);
     }
 
     void performLift(duckdb::DataChunk& args, duckdb::ExpressionState& state, duckdb::Vector& result) {
@@ -124,7 +72,7 @@ public:
                 }
                 return;
             }
-            std::cout << "Valid " << validSets[0].size() << "-sets: " << validSets.size() << "\n";
+            std::cout << "Valid " << lattice::attCount(validSets[0]) << "-sets: " << validSets.size() << "\n";
         }
 
         DuckDBVectorHash hasher;
@@ -137,10 +85,10 @@ public:
             for (const auto& set : validSets) {
                 duckdb::vector<duckdb::Value> selectedAtts;
                 duckdb::vector<duckdb::Value> attValues;
-                for (const auto& idx : set) {
+                lattice::forEachAtt(set, [&](int idx) {
                     attValues.push_back(duckdb::Value::INTEGER(idx));
                     selectedAtts.push_back(tuple[idx]);
-                }
+                });
                 duckdb::Value key = duckdb::Value::LIST(attValues);
                 keys.push_back(key);
                 duckdb::Value value = duckdb::Value::UBIGINT(hasher(selectedAtts));
@@ -184,9 +132,9 @@ public:
         for (const auto& kv : pairs) {
             auto pair = duckdb::MapValue::GetChildren(kv);
             if (duckdb::ListValue::GetChildren(pair[1]).size() == N) {
-                std::set<int> invalidSet;
+                lattice::AttrMask invalidSet = 0;
                 for (const auto& val : duckdb::ListValue::GetChildren(pair[0])) {
-                    invalidSet.insert(val.GetValue<int>());
+                    invalidSet = lattice::withAtt(invalidSet, val.GetValue<int>());
                 }
                 validSets.erase(std::remove(validSets.begin(), validSets.end(), invalidSet), validSets.end());
                 continue;
@@ -0,0 +1,468 @@
+#include "duckdb.hpp"
+
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+
+#include "entropy_store.hpp"
+#include "peak_memory.hpp"
+
+/*
+mine_entropies(table, col...): mine the whole attribute lattice inside the extension.
+Each layer is one streaming scan of the table; chunks are hashed and probed against
+the previous layer's survivors with the hash_if_alive kernel and counted directly, so
+no per-layer SQL is generated, parsed or bound. Yields (attribute_set, entropy,
+distinct_count, tuple_count) rows as each layer completes, tuple_count being the
+number of rows mined (the same on every row). With no columns given, every column
+of table is mined. With store := path the entropies are also saved as an entropy
+store file (see read_entropies) once mining finishes.
+
+A layer's count tables are kept within memory_budget := '<size>' (default: the
+memory_limit setting): candidates are split into batches, each counted in its own
+scan, sized by the rows surviving their subsets. max_layer := n stops mining after
+the n-sets. time_budget := seconds and peak_memory_budget := '<size>' stop mining
+after the first layer that ends past the time budget, or with the process's peak
+resident memory above the size; every layer yielded is complete.
+
+table can be any FROM source, e.g. read_csv('data.csv'), so a file can be mined
+without loading it into a table first. With encode := true the first scan (which
+counts layer 1 while the file is parsed) also keeps every column's 8-byte value
+hashes, and later layers are counted from those instead of scanning (and parsing
+and hashing) table again. The kept hashes may take at most half of memory_budget;
+past that they are dropped and later layers scan table as usual.
+
+Only Apriori candidates (n-sets whose every (n-1)-subset is not a key) are counted;
+supersets of keys are keys themselves and aren't reported.
+
+The scans run on a separate connection, so table must be visible to other
+connections (i.e. committed).
+*/
+
+namespace mineEntropies {
+
+using hash_t = uint64_t;
+
+// Approximate size of one count table entry (node, key, count and bucket)
+const uint64_t COUNT_ENTRY_BYTES = 48;
+// Share of the memory budget encoded column hashes may take (the rest is for count tables)
+const uint64_t ENCODED_BUDGET_DIVISOR = 2;
+// Rows scanned before a batch's count tables are sized from what they hold so far
+const idx_t RESERVE_SAMPLE_ROWS = 1 << 16;
+
+struct MineBindData : public duckdb::TableFunctionData {
+    std::string table;
+    std::vector<std::string> columns;
+    std::string storePath;
+    uint64_t memoryBudget = 0;
+    // Largest att. set size to mine (0: the whole lattice)
+    int maxLayer = 0;
+    bool encode = false;
+    // Checked after every layer (0: no limit)
+    double timeBudget = 0;
+    uint64_t peakMemoryBudget = 0;
+};
+
+// Column hashes of one scanned chunk
+struct EncodedChunk {
+    idx_t size;
+    std::vector<std::vector<hash_t>> colHashes;
+};
+
+struct SetEntropy {
+    lattice::AttrMask atts;
+    double entropy;
+    uint64_t distinctCount;
+};
+
+class LatticeMiner {
+private:
+    duckdb::Connection conn;
+    std::string scanQuery;
+    std::vector<std::string> columns;
+
+    // Bytes the count tables of one pass may take (0: no limit)
+    uint64_t memoryBudget;
+    // Last layer to mine (0: no limit)
+    int maxLayer;
+    // Stop after a layer ending past these (0: no limit)
+    double timeBudget = 0;
+    uint64_t peakMemoryBudget = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // Keep the first scan's column hashes for later layers (turned off if they outgrow their budget)
+    bool encode;
+    std::vector<EncodedChunk> encoded;
+    uint64_t encodedBytes = 0;
+
+    int layer = 0;
+    int64_t tupleCount = 0;
+    // Att. sets of the last layer (in order) and their survivors
+    std::vector<lattice::AttrMask> layerSets;
+    duckdb::shared_ptr<survivorCache::SurvivorEntry> survivors;
+    // Every set mined so far
+    lattice::EntropyStore store;
+
+    template <class CHUNK_FN>
+    void scan(CHUNK_FN &&processChunk) {
+        auto result = conn.SendQuery(scanQuery);
+        while (!result->HasError()) {
+            auto chunk = result->Fetch();
+            if (!chunk || chunk->size() == 0) {
+                break;
+            }
+            processChunk(*chunk);
+        }
+        if (result->HasError()) {
+            throw duckdb::InvalidInputException("mine_entropies scan failed: %s", result->GetError());
+        }
+    }
+
+    /*
+        Call processHashes(colHashes, count) for every chunk of table, from the
+        encoded columns if the first scan kept them.
+    */
+    template <class HASH_FN>
+    void scanHashes(HASH_FN &&processHashes) {
+        if (encode) {
+            for (const auto& chunk : encoded) {
+                processHashes(chunk.colHashes, chunk.size);
+            }
+            return;
+        }
+
+        std::vector<std::vector<hash_t>> colHashes(columns.size());
+        scan([&](duckdb::DataChunk &chunk) {
+            hashIfAlive::hashColumns(chunk, 0, colHashes);
+            processHashes(colHashes, chunk.size());
+        });
+    }
+
+    duckdb::shared_ptr<survivorCache::SurvivorEntry> newLayer(idx_t setCount) {
+        auto next = duckdb::make_shared_ptr<survivorCache::SurvivorEntry>();
+        next->sets.resize(setCount);
+        next->rowCounts.resize(setCount);
+        next->tupleCount = tupleCount;
+        return next;
+    }
+
+    /*
+        Turn the counts of sets[first, first + counts.size()) into their entropies and
+        the survivors (non-unique hashes) the next layer is pruned with. Returns true
+        if any of them has survivors.
+    */
+    bool finalizeSets(const std::vector<lattice::AttrMask> &sets, idx_t first, std::vector<std::unordered_map<hash_t, int64_t>> &counts,
+                      survivorCache::SurvivorEntry &next, std::vector<SetEntropy> &out) {
+        bool anySurvivors = false;
+        for (idx_t c = 0; c < counts.size(); c++) {
+            auto i = first + c;
+            // Unique values contribute 1 * log2(1) = 0, so pruned tuples don't change the sum
+            double sum = 0.0;
+            int64_t counted = 0;
+            std::vector<hash_t> sortedUnpruned;
+            for (const auto& [k, v] : counts[c]) {
+                counted += v;
+                if (v > 1) {
+                    sum += (double) v * std::log2((double) v);
+                    sortedUnpruned.push_back(k);
+                    next.rowCounts[i] += v;
+                }
+            }
+            std::sort(sortedUnpruned.begin(), sortedUnpruned.end());
+            anySurvivors = anySurvivors || !sortedUnpruned.empty();
+            next.sets[i] = eytzinger::build(sortedUnpruned);
+
+            // H(A) = log2(N) - 1/N (SUM count(a) * log2(count(a)))
+            double entropy = tupleCount > 0 ? std::log2((double) tupleCount) - sum / tupleCount : 0.0;
+            // Pruned tuples are unique in a subset, so each is a distinct value of the set
+            uint64_t distinctCount = counts[c].size() + (tupleCount - counted);
+            out.push_back({sets[i], entropy, distinctCount});
+            store.put(sets[i], entropy, distinctCount);
+            std::unordered_map<hash_t, int64_t>().swap(counts[c]);
+        }
+        return anySurvivors;
+    }
+
+    bool computeFirstLayer(std::vector<SetEntropy> &out) {
+        std::vector<std::unordered_map<hash_t, int64_t>> counts(columns.size());
+        std::vector<std::vector<hash_t>> colHashes(columns.size());
+
+        scan([&](duckdb::DataChunk &chunk) {
+            hashIfAlive::hashColumns(chunk, 0, colHashes);
+            for (idx_t col = 0; col < columns.size(); col++) {
+                for (idx_t row = 0; row < chunk.size(); row++) {
+                    counts[col][colHashes[col][row]]++;
+                }
+            }
+            tupleCount += chunk.size();
+            if (encode) {
+                encodedBytes += chunk.size() * columns.size() * sizeof(hash_t);
+                if (memoryBudget > 0 && encodedBytes > memoryBudget / ENCODED_BUDGET_DIVISOR) {
+                    // Too large to keep: later layers scan table instead
+                    std::vector<EncodedChunk>().swap(encoded);
+                    encodedBytes = 0;
+                    encode = false;
+                } else {
+                    encoded.push_back({chunk.size(), colHashes});
+                }
+            }
+        });
+        store.setTupleCount(tupleCount);
+
+        auto sets = hashIfAlive::getCombinations(columns.size(), 1);
+        auto next = newLayer(sets.size());
+        bool anySurvivors = finalizeSets(sets, 0, counts, *next, out);
+        layerSets = std::move(sets);
+        survivors = std::move(next);
+        return anySurvivors;
+    }
+
+    /*
+        Upper bound on the bytes each candidate's count table takes: it holds at most
+        one entry per row surviving all its subsets, so the smallest subset row count.
+    */
+    std::vector<uint64_t> estimateCountSizes(const std::vector<hashIfAlive::Candidate> &candidates) {
+        std::vector<uint64_t> sizes;
+        for (const auto& candidate : candidates) {
+            int64_t rows = candidate.dead ? 0 : tupleCount;
+            for (const auto& subset : candidate.subsets) {
+                rows = std::min(rows, survivors->rowCounts[subset.second]);
+            }
+            sizes.push_back(rows * COUNT_ENTRY_BYTES);
+        }
+        return sizes;
+    }
+
+    /*
+        Reserve room in each count table for its estimated distinct count, once
+        scanned rows of the table have been counted, so the tables don't rehash
+        over and over while they grow. The counts so far are a sample: with d
+        distinct values, f1 of them seen once, the GEE estimate sqrt(N / scanned)
+        * f1 + (d - f1) is used, capped by the candidate's row bound. It's only a
+        hint; a table that outgrows it still grows as usual.
+    */
+    void reserveCounts(std::vector<std::unordered_map<hash_t, int64_t>> &counts, const std::vector<uint64_t> &rowBounds, idx_t scanned) {
+        double scale = std::sqrt((double) tupleCount / scanned);
+        for (idx_t c = 0; c < counts.size(); c++) {
+            uint64_t singletons = 0;
+            for (const auto& entry : counts[c]) {
+                singletons += entry.second == 1;
+            }
+            double estimate = scale * singletons + (counts[c].size() - singletons);
+            counts[c].reserve(std::min<uint64_t>(estimate, rowBounds[c]));
+        }
+    }
+
+    bool computeSingleLayer(int n, std::vector<SetEntropy> &out) {
+        // Only n-sets whose every (n-1)-subset has survivors can be non-keys
+        std::vector<lattice::AttrMask> survivingSets;
+        for (idx_t i = 0; i < layerSets.size(); i++) {
+            if (!survivors->sets[i].empty()) {
+                survivingSets.push_back(layerSets[i]);
+            }
+        }
+        auto sets = lattice::aprioriCandidates(survivingSets);
+        if (sets.empty()) {
+            return false;
+        }
+
+        auto candidates = hashIfAlive::makeCandidates(layerSets, sets, *survivors);
+        hashIfAlive::ProbeStats stats(survivors->sets.size());
+        auto next = newLayer(sets.size());
+        bool anySurvivors = false;
+
+        // One pass over the table per batch of candidates fitting the memory budget
+        // Encoded columns stay in memory alongside the count tables (within half the budget)
+        uint64_t budget = memoryBudget > 0 ? memoryBudget - encodedBytes : 0;
+        auto sizes = estimateCountSizes(*candidates);
+        auto bounds = lattice::batchBounds(sizes, budget);
+        for (idx_t b = 0; b + 1 < bounds.size(); b++) {
+            std::vector<hashIfAlive::Candidate> batch(candidates->begin() + bounds[b], candidates->begin() + bounds[b + 1]);
+            std::vector<std::unordered_map<hash_t, int64_t>> counts(batch.size());
+            std::vector<uint64_t> rowBounds;
+            for (idx_t i = bounds[b]; i < bounds[b + 1]; i++) {
+                rowBounds.push_back(sizes[i] / COUNT_ENTRY_BYTES);
+            }
+
+            idx_t scanned = 0;
+            scanHashes([&](const std::vector<std::vector<hash_t>> &colHashes, idx_t count) {
+                hashIfAlive::probeChunk(colHashes, count, *survivors, batch, stats, [&](idx_t c, idx_t row, hash_t hash) {
+                    counts[c][hash]++;
+                });
+                if (scanned < RESERVE_SAMPLE_ROWS && scanned + count >= RESERVE_SAMPLE_ROWS && scanned + count < (idx_t) tupleCount) {
+                    reserveCounts(counts, rowBounds, scanned + count);
+                }
+                scanned += count;
+            });
+            anySurvivors = finalizeSets(sets, bounds[b], counts, *next, out) || anySurvivors;
+        }
+
+        layerSets = std::move(sets);
+        survivors = std::move(next);
+        return anySurvivors;
+    }
+
+public:
+    LatticeMiner(duckdb::DatabaseInstance &db, const std::string &table, std::vector<std::string> requested, uint64_t memoryBudget, int maxLayer, bool encode) :
+        conn(db), memoryBudget(memoryBudget), maxLayer(maxLayer), encode(encode) {
+        // Resolve (and validate) the mined columns
+        std::string projection = "*";
+        if (!requested.empty()) {
+            projection = "";
+            for (const auto& col : requested) {
+                projection += duckdb::KeywordHelper::WriteOptionallyQuoted(col) + ", ";
+            }
+            projection.resize(projection.size() - 2);
+        }
+        scanQuery = "SELECT " + projection + " FROM " + table;
+
+        auto schema = conn.Query(scanQuery + " LIMIT 0");
+        if (schema->HasError()) {
+            throw duckdb::InvalidInputException("mine_entropies: %s", schema->GetError());
+        }
+        columns = schema->names;
+        if (columns.size() > lattice::MAX_ATTRIBUTES) {
+            throw duckdb::InvalidInputException("mine_entropies supports at most %d columns, got %llu", lattice::MAX_ATTRIBUTES, columns.size());
+        }
+    }
+
+    void setBudgets(double seconds, uint64_t peakMemory) {
+        timeBudget = seconds;
+        peakMemoryBudget = peakMemory;
+    }
+
+    const std::vector<std::string>& getColumns() const {
+        return columns;
+    }
+
+    const lattice::EntropyStore& getStore() const {
+        return store;
+    }
+
+    // Rows of table, known once the first layer is mined
+    int64_t getTupleCount() const {
+        return tupleCount;
+    }
+
+    /*
+        Compute the next layer and append its entropies to out. Returns false once
+        no further layer can hold a non-key set, maxLayer is reached or a budget
+        is used up.
+    */
+    bool nextLayer(std::vector<SetEntropy> &out) {
+        layer++;
+        bool anySurvivors = layer == 1 ? computeFirstLayer(out) : computeSingleLayer(layer, out);
+        return anySurvivors && layer < (int) columns.size() && (maxLayer == 0 || layer < maxLayer) && !budgetExceeded();
+    }
+
+    bool budgetExceeded() const {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return (timeBudget > 0 && seconds >= timeBudget) ||
+               (peakMemoryBudget > 0 && lattice::peakMemoryBytes() >= peakMemoryBudget);
+    }
+};
+
+struct MineGlobalState : public duckdb::GlobalTableFunctionState {
+    duckdb::unique_ptr<LatticeMiner> miner;
+    std::vector<SetEntropy> pending;
+    idx_t offset = 0;
+    bool exhausted = false;
+};
+
+duckdb::unique_ptr<duckdb::FunctionData> mineEntropiesBind(duckdb::ClientContext &context, duckdb::TableFunctionBindInput &input, duckdb::vector<duckdb::LogicalType> &returnTypes, duckdb::vector<std::string> &names) {
+    auto bindData = duckdb::make_uniq<MineBindData>();
+    bindData->table = input.inputs[0].ToString();
+    for (idx_t i = 1; i < input.inputs.size(); i++) {
+        bindData->columns.push_back(input.inputs[i].ToString());
+    }
+    auto store = input.named_parameters.find("store");
+    if (store != input.named_parameters.end()) {
+        bindData->storePath = store->second.ToString();
+    }
+
+    // Count tables live outside the buffer manager, so keep them within memory_limit by default
+    auto &options = duckdb::DBConfig::GetConfig(context).options;
+    bindData->memoryBudget = options.maximum_memory == duckdb::DConstants::INVALID_INDEX ? 0 : options.maximum_memory;
+    auto budget = input.named_parameters.find("memory_budget");
+    if (budget != input.named_parameters.end()) {
+        bindData->memoryBudget = duckdb::DBConfig::ParseMemoryLimit(budget->second.ToString());
+    }
+    auto maxLayer = input.named_parameters.find("max_layer");
+    if (maxLayer != input.named_parameters.end()) {
+        bindData->maxLayer = maxLayer->second.GetValue<int32_t>();
+        if (bindData->maxLayer < 1) {
+            throw duckdb::BinderException("mine_entropies: max_layer must be at least 1, got %d", bindData->maxLayer);
+        }
+    }
+    auto encode = input.named_parameters.find("encode");
+    if (encode != input.named_parameters.end()) {
+        bindData->encode = encode->second.GetValue<bool>();
+    }
+    auto timeBudget = input.named_parameters.find("time_budget");
+    if (timeBudget != input.named_parameters.end()) {
+        bindData->timeBudget = timeBudget->second.GetValue<double>();
+        if (bindData->timeBudget <= 0) {
+            throw duckdb::BinderException("mine_entropies: time_budget must be positive, got %f", bindData->timeBudget);
+        }
+    }
+    auto peakMemoryBudget = input.named_parameters.find("peak_memory_budget");
+    if (peakMemoryBudget != input.named_parameters.end()) {
+        bindData->peakMemoryBudget = duckdb::DBConfig::ParseMemoryLimit(peakMemoryBudget->second.ToString());
+    }
+
+    returnTypes.push_back(duckdb::LogicalType::LIST(duckdb::LogicalType::VARCHAR));
+    names.push_back("attribute_set");
+    returnTypes.push_back(duckdb::LogicalType::DOUBLE);
+    names.push_back("entropy");
+    returnTypes.push_back(duckdb::LogicalType::UBIGINT);
+    names.push_back("distinct_count");
+    returnTypes.push_back(duckdb::LogicalType::UBIGINT);
+    names.push_back("tuple_count");
+    return std::move(bindData);
+}
+
+duckdb::unique_ptr<duckdb::GlobalTableFunctionState> mineEntropiesInit(duckdb::ClientContext &context, duckdb::TableFunctionInitInput &input) {
+    auto &bindData = input.bind_data->Cast<MineBindData>();
+    auto state = duckdb::make_uniq<MineGlobalState>();
+    state->miner = duckdb::make_uniq<LatticeMiner>(duckdb::DatabaseInstance::GetDatabase(context), bindData.table, bindData.columns, bindData.memoryBudget, bindData.maxLayer, bindData.encode);
+    state->miner->setBudgets(bindData.timeBudget, bindData.peakMemoryBudget);
+    return std::move(state);
+}
+
+void mineEntropiesFunction(duckdb::ClientContext &context, duckdb::TableFunctionInput &input, duckdb::DataChunk &output) {
+    auto &bindData = input.bind_data->Cast<MineBindData>();
+    auto &state = input.global_state->Cast<MineGlobalState>();
+
+    // Mine layers until there's something to emit
+    while (state.offset == state.pending.size() && !state.exhausted) {
+        state.pending.clear();
+        state.offset = 0;
+        state.exhausted = !state.miner->nextLayer(state.pending);
+
+        if (state.exhausted && !bindData.storePath.empty()) {
+            try {
+                state.miner->getStore().save(bindData.storePath);
+            } catch (std::runtime_error &e) {
+                throw duckdb::IOException(e.what());
+            }
+        }
+    }
+
+    auto &columns = state.miner->getColumns();
+    idx_t count = 0;
+    for (; state.offset < state.pending.size() && count < STANDARD_VECTOR_SIZE; state.offset++, count++) {
+        auto &set = state.pending[state.offset];
+        duckdb::vector<duckdb::Value> attNames;
+        lattice::forEachAtt(set.atts, [&](int att) {
+            attNames.push_back(duckdb::Value(columns[att]));
+        });
+        output.SetValue(0, count, duckdb::Value::LIST(duckdb::LogicalType::VARCHAR, attNames));
+        output.SetValue(1, count, duckdb::Value::DOUBLE(set.entropy));
+        output.SetValue(2, count, duckdb::Value::UBIGINT(set.distinctCount));
+        output.SetValue(3, count, duckdb::Value::UBIGINT(state.miner->getTupleCount()));
+    }
+    output.SetCardinality(count);
+}
+
+} // namespace mineEntropies
@@ -18,9 +18,15 @@
 #include "sum_no_lift.cpp"
 #include "prune.cpp"
 
+#include "eytzinger.cpp"
+#include "survivor_cache.cpp"
 #include "hash_list.cpp"
 #include "sum_dict.cpp"
 #include "filt.cpp"
+#include "hash_if_alive.cpp"
+#include "mine_entropies.cpp"
+#include "read_entropies.cpp"
+#include "read_encoded.cpp"
 
 // OpenSSL linked through vcpkg
 #include <openssl/opensslv.h>
@@ -41,10 +47,11 @@ void registerHashListFunction(DuckDB &db) {
 }
 
 void registerSumDictFunction(DuckDB &db) {
-	auto argTypes = {LogicalType::LIST(LogicalType::UBIGINT)};
+	duckdb::vector<LogicalType> argTypes = {LogicalType::LIST(LogicalType::UBIGINT)};
 	duckdb::vector<std::pair<std::string, duckdb::LogicalType>> structTypes;
     structTypes.push_back(std::make_pair("sets", duckdb::LogicalType::LIST(duckdb::LogicalType::LIST(duckdb::LogicalType::UBIGINT))));
     structTypes.push_back(std::make_pair("entropies", duckdb::LogicalType::LIST(duckdb::LogicalType::DOUBLE)));
+    structTypes.push_back(std::make_pair("distinct_counts", duckdb::LogicalType::LIST(duckdb::LogicalType::UBIGINT)));
 	auto returnType = duckdb::LogicalType::STRUCT(structTypes);
 
 	auto sumDictFunc = AggregateFunction(
@@ -61,7 +68,15 @@ void registerSumDictFunction(DuckDB &db) {
 		AggregateFunction::StateDestroy<sumDict::SumDictState, sumDict::SumDictFunction>
 	);
 
-	ExtensionUtil::RegisterFunction(*db.instance, sumDictFunc);
+	// Keyed variant also registers its survivors in the object cache
+	auto sumDictCachedFunc = sumDictFunc;
+	sumDictCachedFunc.arguments.push_back(LogicalType::VARCHAR); // survivor key
+	sumDictCachedFunc.bind = sumDict::sumDictCachedBind;
+
+	AggregateFunctionSet sumDictSet("sum_dict");
+	sumDictSet.AddFunction(sumDictFunc);
+	sumDictSet.AddFunction(sumDictCachedFunc);
+	ExtensionUtil::RegisterFunction(*db.instance, sumDictSet);
 }
 
 void registerFiltFunction(DuckDB &db) {
@@ -77,7 +92,151 @@ void registerFiltFunction(DuckDB &db) {
 		returnType,
 		filt::filtFunction
 	);
-	ExtensionUtil::RegisterFunction(*db.instance, filtFunc);
+
+	// Keyed variant probing survivors registered by sum_dict(..., key)
+	duckdb::vector<LogicalType> cachedArgTypes = {
+		LogicalType::UBIGINT, // search hash
+		LogicalType::VARCHAR, // survivor key
+		LogicalType::INTEGER  // set offset
+	};
+	auto filtCachedFunc = ScalarFunction(
+		"filt",
+		cachedArgTypes,
+		returnType,
+		filt::filtCachedFunction,
+		filt::filtCachedBind
+	);
+
+	ScalarFunctionSet filtSet("filt");
+	filtSet.AddFunction(filtFunc);
+	filtSet.AddFunction(filtCachedFunc);
+	ExtensionUtil::RegisterFunction(*db.instance, filtSet);
+}
+
+void registerHashRowFunction(DuckDB &db) {
+	auto hashRowFunc = ScalarFunction(
+		"hash_row",
+		{},
+		LogicalType::UBIGINT,
+		hashIfAlive::hashRowFunction
+	);
+	hashRowFunc.varargs = LogicalType::ANY; // attribute columns, of any type
+	hashRowFunc.null_handling = FunctionNullHandling::SPECIAL_HANDLING; // NULLs hash to 0
+	ExtensionUtil::RegisterFunction(*db.instance, hashRowFunc);
+}
+
+void registerHashAttsFunction(DuckDB &db) {
+	auto hashAttsFunc = ScalarFunction(
+		"hash_atts",
+		{LogicalType::LIST(LogicalType::INTEGER)}, // indexes of the hashed columns
+		LogicalType::UBIGINT,
+		hashIfAlive::hashAttsFunction,
+		hashIfAlive::hashAttsBind
+	);
+	hashAttsFunc.varargs = LogicalType::ANY; // attribute columns, of any type
+	hashAttsFunc.null_handling = FunctionNullHandling::SPECIAL_HANDLING; // NULLs hash to 0
+	ExtensionUtil::RegisterFunction(*db.instance, hashAttsFunc);
+}
+
+void registerHashIfAliveFunction(DuckDB &db) {
+	auto returnType = LogicalType::LIST(LogicalType::UBIGINT);
+	auto attSetsType = LogicalType::LIST(LogicalType::LIST(LogicalType::INTEGER));
+
+	duckdb::vector<LogicalType> argTypes = {
+		LogicalType::VARCHAR, // survivor key of previous layer
+		LogicalType::INTEGER  // layer (set size)
+	};
+	auto hashIfAliveFunc = ScalarFunction(
+		"hash_if_alive",
+		argTypes,
+		returnType,
+		hashIfAlive::hashIfAliveFunction,
+		hashIfAlive::hashIfAliveBind,
+		nullptr,
+		nullptr,
+		hashIfAlive::hashIfAliveInitLocal
+	);
+	hashIfAliveFunc.varargs = LogicalType::ANY; // attribute columns, of any type
+	hashIfAliveFunc.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+
+	// Explicit layer layouts, e.g. Apriori candidates
+	auto hashIfAliveSetsFunc = hashIfAliveFunc;
+	hashIfAliveSetsFunc.arguments = {
+		LogicalType::VARCHAR, // survivor key of previous layer
+		attSetsType,          // previous layer's att. sets
+		attSetsType           // this layer's att. sets
+	};
+	hashIfAliveSetsFunc.bind = hashIfAlive::hashIfAliveSetsBind;
+
+	ScalarFunctionSet hashIfAliveSet("hash_if_alive");
+	hashIfAliveSet.AddFunction(hashIfAliveFunc);
+	hashIfAliveSet.AddFunction(hashIfAliveSetsFunc);
+	ExtensionUtil::RegisterFunction(*db.instance, hashIfAliveSet);
+}
+
+void registerMineEntropiesFunction(DuckDB &db) {
+	auto mineEntropiesFunc = TableFunction(
+		"mine_entropies",
+		{LogicalType::VARCHAR}, // table
+		mineEntropies::mineEntropiesFunction,
+		mineEntropies::mineEntropiesBind,
+		mineEntropies::mineEntropiesInit
+	);
+	mineEntropiesFunc.varargs = LogicalType::VARCHAR; // columns (default: all)
+	mineEntropiesFunc.named_parameters["store"] = LogicalType::VARCHAR; // entropy store file to write
+	mineEntropiesFunc.named_parameters["memory_budget"] = LogicalType::VARCHAR; // e.g. '4GB'
+	mineEntropiesFunc.named_parameters["max_layer"] = LogicalType::INTEGER; // largest att. set size
+	mineEntropiesFunc.named_parameters["encode"] = LogicalType::BOOLEAN; // reuse the first scan's hashes
+	mineEntropiesFunc.named_parameters["time_budget"] = LogicalType::DOUBLE; // seconds, checked after every layer
+	mineEntropiesFunc.named_parameters["peak_memory_budget"] = LogicalType::VARCHAR; // e.g. '16GB', checked after every layer
+	ExtensionUtil::RegisterFunction(*db.instance, mineEntropiesFunc);
+}
+
+void registerReadEntropiesFunction(DuckDB &db) {
+	auto readEntropiesFunc = TableFunction(
+		"read_entropies",
+		{LogicalType::VARCHAR}, // entropy store file
+		readEntropies::readEntropiesFunction,
+		readEntropies::readEntropiesBind,
+		readEntropies::readEntropiesInit
+	);
+	ExtensionUtil::RegisterFunction(*db.instance, readEntropiesFunc);
+}
+
+void registerReadEncodedFunction(DuckDB &db) {
+	auto readEncodedFunc = TableFunction(
+		"read_encoded",
+		{LogicalType::VARCHAR}, // encoded dataset file
+		readEncoded::readEncodedFunction,
+		readEncoded::readEncodedBind,
+		readEncoded::readEncodedInit
+	);
+	readEncodedFunc.projection_pushdown = true;
+	ExtensionUtil::RegisterFunction(*db.instance, readEncodedFunc);
+}
+
+void registerDropSurvivorsFunction(DuckDB &db) {
+	auto dropSurvivorsFunc = ScalarFunction(
+		"drop_survivors",
+		{LogicalType::VARCHAR}, // survivor key
+		LogicalType::BOOLEAN,   // whether the key was registered
+		survivorCache::dropSurvivorsFunction,
+		survivorCache::dropSurvivorsBind
+	);
+	dropSurvivorsFunc.stability = FunctionStability::VOLATILE;
+	ExtensionUtil::RegisterFunction(*db.instance, dropSurvivorsFunc);
+}
+
+void registerMergeSurvivorsFunction(DuckDB &db) {
+	auto mergeSurvivorsFunc = ScalarFunction(
+		"merge_survivors",
+		{LogicalType::VARCHAR, LogicalType::LIST(LogicalType::VARCHAR)}, // merged key, batch keys
+		LogicalType::BOOLEAN,
+		survivorCache::mergeSurvivorsFunction,
+		survivorCache::mergeSurvivorsBind
+	);
+	mergeSurvivorsFunc.stability = FunctionStability::VOLATILE;
+	ExtensionUtil::RegisterFunction(*db.instance, mergeSurvivorsFunc);
 }
 
 
@@ -201,6 +360,14 @@ void QuackExtension::Load(DuckDB &db) {
 	registerHashListFunction(db);
 	registerSumDictFunction(db);
 	registerFiltFunction(db);
+	registerHashRowFunction(db);
+	registerHashAttsFunction(db);
+	registerHashIfAliveFunction(db);
+	registerMineEntropiesFunction(db);
+	registerReadEntropiesFunction(db);
+	registerReadEncodedFunction(db);
+	registerDropSurvivorsFunction(db);
+	registerMergeSurvivorsFunction(db);
 }
 
 std::string QuackExtension::Name() {
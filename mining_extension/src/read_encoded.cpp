@@ -0,0 +1,83 @@
+#include "duckdb.hpp"
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstring>
+
+#include "encoded_dataset.hpp"
+
+/*
+read_encoded(path): the columns of an encoded dataset file (written by the
+SchemaMiner driver's dataset cache) as col0..col[n-1] UBIGINT cell hashes. The
+file is memory mapped and scanned in place, in parallel, so a cached dataset is
+mined without reading or parsing its source again. Only the projected columns
+are read.
+*/
+
+namespace readEncoded {
+
+struct EncodedBindData : public duckdb::TableFunctionData {
+    duckdb::shared_ptr<lattice::MappedEncodedDataset> dataset;
+};
+
+struct EncodedGlobalState : public duckdb::GlobalTableFunctionState {
+    std::vector<duckdb::column_t> columnIds;
+    std::atomic<idx_t> nextRow{0};
+    idx_t maxThreads = 1;
+
+    idx_t MaxThreads() const override {
+        return maxThreads;
+    }
+};
+
+duckdb::unique_ptr<duckdb::FunctionData> readEncodedBind(duckdb::ClientContext &context, duckdb::TableFunctionBindInput &input, duckdb::vector<duckdb::LogicalType> &returnTypes, duckdb::vector<std::string> &names) {
+    auto bindData = duckdb::make_uniq<EncodedBindData>();
+    try {
+        bindData->dataset = duckdb::make_shared_ptr<lattice::MappedEncodedDataset>(input.inputs[0].ToString());
+    } catch (std::runtime_error &e) {
+        throw duckdb::IOException(e.what());
+    }
+
+    for (uint64_t col = 0; col < bindData->dataset->columnCount(); col++) {
+        returnTypes.push_back(duckdb::LogicalType::UBIGINT);
+        names.push_back("col" + std::to_string(col));
+    }
+    return std::move(bindData);
+}
+
+duckdb::unique_ptr<duckdb::GlobalTableFunctionState> readEncodedInit(duckdb::ClientContext &context, duckdb::TableFunctionInitInput &input) {
+    auto &bindData = input.bind_data->Cast<EncodedBindData>();
+    auto state = duckdb::make_uniq<EncodedGlobalState>();
+    state->columnIds.assign(input.column_ids.begin(), input.column_ids.end());
+    // One vector per task; threads take the next unread vector
+    state->maxThreads = std::max<idx_t>(1, bindData.dataset->rowCount() / (STANDARD_VECTOR_SIZE * 16));
+    return std::move(state);
+}
+
+void readEncodedFunction(duckdb::ClientContext &context, duckdb::TableFunctionInput &input, duckdb::DataChunk &output) {
+    auto &dataset = *input.bind_data->Cast<EncodedBindData>().dataset;
+    auto &state = input.global_state->Cast<EncodedGlobalState>();
+
+    idx_t start = state.nextRow.fetch_add(STANDARD_VECTOR_SIZE);
+    if (start >= dataset.rowCount()) {
+        output.SetCardinality(0);
+        return;
+    }
+    idx_t count = std::min<idx_t>(STANDARD_VECTOR_SIZE, dataset.rowCount() - start);
+
+    for (idx_t i = 0; i < state.columnIds.size(); i++) {
+        auto col = state.columnIds[i];
+        if (col == duckdb::COLUMN_IDENTIFIER_ROW_ID) {
+            auto rowIds = duckdb::FlatVector::GetData<int64_t>(output.data[i]);
+            for (idx_t row = 0; row < count; row++) {
+                rowIds[row] = start + row;
+            }
+            continue;
+        }
+        std::memcpy(duckdb::FlatVector::GetData<uint64_t>(output.data[i]), dataset.column(col) + start, count * sizeof(uint64_t));
+    }
+    output.SetCardinality(count);
+}
+
+} // namespace readEncoded
@@ -0,0 +1,79 @@
+#include "duckdb.hpp"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "entropy_store.hpp"
+
+/*
+read_entropies(path): the att. sets of an entropy store file (written by the
+SchemaMiner driver or mine_entropies(..., store := path)) as (attribute_set,
+entropy, distinct_count) rows, smallest sets first. Att. sets are column indices.
+The file is memory mapped, so reading a store doesn't re-mine the dataset.
+*/
+
+namespace readEntropies {
+
+struct ReadBindData : public duckdb::TableFunctionData {
+    std::string path;
+};
+
+struct ReadGlobalState : public duckdb::GlobalTableFunctionState {
+    duckdb::unique_ptr<lattice::MappedEntropyStore> store;
+    std::vector<lattice::EntropyRecord> records;
+    idx_t offset = 0;
+};
+
+duckdb::unique_ptr<duckdb::FunctionData> readEntropiesBind(duckdb::ClientContext &context, duckdb::TableFunctionBindInput &input, duckdb::vector<duckdb::LogicalType> &returnTypes, duckdb::vector<std::string> &names) {
+    auto bindData = duckdb::make_uniq<ReadBindData>();
+    bindData->path = input.inputs[0].ToString();
+
+    returnTypes.push_back(duckdb::LogicalType::LIST(duckdb::LogicalType::INTEGER));
+    names.push_back("attribute_set");
+    returnTypes.push_back(duckdb::LogicalType::DOUBLE);
+    names.push_back("entropy");
+    returnTypes.push_back(duckdb::LogicalType::UBIGINT);
+    names.push_back("distinct_count");
+    return std::move(bindData);
+}
+
+duckdb::unique_ptr<duckdb::GlobalTableFunctionState> readEntropiesInit(duckdb::ClientContext &context, duckdb::TableFunctionInitInput &input) {
+    auto &bindData = input.bind_data->Cast<ReadBindData>();
+    auto state = duckdb::make_uniq<ReadGlobalState>();
+    try {
+        state->store = duckdb::make_uniq<lattice::MappedEntropyStore>(bindData.path);
+    } catch (std::runtime_error &e) {
+        throw duckdb::IOException(e.what());
+    }
+
+    // Slots are in hash order; report by layer, then lexicographically
+    state->store->forEach([&](const lattice::EntropyRecord &record) {
+        state->records.push_back(record);
+    });
+    std::sort(state->records.begin(), state->records.end(), [](const lattice::EntropyRecord &a, const lattice::EntropyRecord &b) {
+        int sizeA = lattice::attCount(a.mask);
+        int sizeB = lattice::attCount(b.mask);
+        return sizeA != sizeB ? sizeA < sizeB : lattice::lexLess(a.mask, b.mask);
+    });
+    return std::move(state);
+}
+
+void readEntropiesFunction(duckdb::ClientContext &context, duckdb::TableFunctionInput &input, duckdb::DataChunk &output) {
+    auto &state = input.global_state->Cast<ReadGlobalState>();
+
+    idx_t count = 0;
+    for (; state.offset < state.records.size() && count < STANDARD_VECTOR_SIZE; state.offset++, count++) {
+        auto &record = state.records[state.offset];
+        duckdb::vector<duckdb::Value> atts;
+        lattice::forEachAtt(record.mask, [&](int att) {
+            atts.push_back(duckdb::Value::INTEGER(att));
+        });
+        output.SetValue(0, count, duckdb::Value::LIST(duckdb::LogicalType::INTEGER, atts));
+        output.SetValue(1, count, duckdb::Value::DOUBLE(record.entropy));
+        output.SetValue(2, count, duckdb::Value::UBIGINT(record.distinctCount));
+    }
+    output.SetCardinality(count);
+}
+
+} // namespace readEntropies
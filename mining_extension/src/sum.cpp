@@ -3,7 +3,8 @@
 #include <map>
 #include <iostream>
 #include <vector>
-#include <set>
+
+#include "attr_mask.hpp"
 
 // TODO: We don't need to save the values in the map, just the count
 // all we care about is the relevent distribution
@@ -16,13 +17,13 @@
 namespace customSum {
 
 using hash_t = uint64_t;
-using AttributeSet = std::set<int>;
+using AttributeSet = lattice::AttrMask;
 
 void printAttributeSet(const AttributeSet& attSet) {
     std::string out = "[";
-    for (const int i : attSet) {
+    lattice::forEachAtt(attSet, [&](int i) {
         out += std::to_string(i) + ", ";
-    }
+    });
     out.pop_back();
     out.pop_back();
     out += "]\n";
@@ -75,9 +76,9 @@ static void customSumUpdate(duckdb::Vector inputs[], duckdb::AggregateInputData
     auto firstMap = duckdb::MapValue::GetChildren(inputMaps.GetValue(0));
     for (idx_t i = 0; i < combinationCount; i++) {
         auto attrSet = duckdb::MapValue::GetChildren(firstMap[i])[0];
-        std::set<int> attIndeces;
+        AttributeSet attIndeces = 0;
         for (const auto& attr : duckdb::ListValue::GetChildren(attrSet)) {
-            attIndeces.insert(attr.GetValue<int>());
+            attIndeces = lattice::withAtt(attIndeces, attr.GetValue<int>());
         }
         state.attributeSets[i] = attIndeces;
     }
@@ -146,11 +147,11 @@ static void customSumFinalize(duckdb::Vector &stateVector, duckdb::AggregateInpu
     for (idx_t i = 0; i < resultCount; i++) {
         // Create duckdb::Value for key
         AttributeSet attSet = state.attributeSets[i];
-        duckdb::vector<duckdb::Value> keyVec(attSet.size());
+        duckdb::vector<duckdb::Value> keyVec(lattice::attCount(attSet));
         size_t idx = 0;
-        for (const int att : attSet) {
+        lattice::forEachAtt(attSet, [&](int att) {
             keyVec[idx++] = duckdb::Value::INTEGER(att);
-        }
+        });
         keys[i] = duckdb::Value::LIST(keyVec);
 
         // Create duckdb::Value for value
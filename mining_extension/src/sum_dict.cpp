@@ -11,12 +11,31 @@ using hash_t = uint64_t;
 
 struct SumDictState {
     std::vector<std::map<hash_t, int64_t>> maps;
+    // Rows aggregated, including those whose hashes were pruned (NULL)
+    int64_t rows;
+};
+
+struct SumDictBindData : public duckdb::FunctionData {
+    // Key to register survivors under in the object cache (empty: don't register)
+    std::string key;
+    duckdb::optional_ptr<duckdb::ObjectCache> cache;
+
+    SumDictBindData() = default;
+    SumDictBindData(std::string key, duckdb::optional_ptr<duckdb::ObjectCache> cache) : key(std::move(key)), cache(cache) {}
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<SumDictBindData>(key, cache);
+    }
+
+    bool Equals(const duckdb::FunctionData &other) const override {
+        return key == other.Cast<SumDictBindData>().key;
+    }
 };
 
 struct SumDictFunction {
     template <class STATE>
     static void Initialize(STATE &state) {
-        return;
+        state.rows = 0;
     }
 
     template <class STATE>
@@ -40,6 +59,7 @@ static void sumDictUpdate(duckdb::Vector inputs[], duckdb::AggregateInputData &,
     // Create container for maps
     auto combinationCount = duckdb::MapValue::GetChildren(inputList.GetValue(0)).size();
     state.maps.resize(combinationCount);
+    state.rows += count;
 
     // Count occurrences of each hashed value 
     for (idx_t i = 0; i < count; i++) {
@@ -67,6 +87,7 @@ static void sumDictCombine(duckdb::Vector &stateVector, duckdb::Vector &combined
             continue;
         }
 
+        combinedPtr[i]->rows += state.rows;
         if (combinedPtr[i]->maps.empty()) {
             // Combined not initialized, copy over maps
             combinedPtr[i]->maps = state.maps;
@@ -82,10 +103,13 @@ static void sumDictCombine(duckdb::Vector &stateVector, duckdb::Vector &combined
     }
 }
 
-static void sumDictFinalize(duckdb::Vector &stateVector, duckdb::AggregateInputData &, duckdb::Vector &result, idx_t count, idx_t offset) {
+static void sumDictFinalize(duckdb::Vector &stateVector, duckdb::AggregateInputData &aggrInputData, duckdb::Vector &result, idx_t count, idx_t offset) {
     // Output contains a struct with two fields:
-    // 1. 'sets': A list of UBIGINTs for each value (for each att set, a set of valid un-pruned vals)
+    // 1. 'sets': A list of UBIGINTs for each value (for each att set, a set of valid un-pruned vals
+    //    in Eytzinger order)
     // 2. 'entropies': A list of doubles: the entropy of each att set
+    // 3. 'distinct_counts': A list of UBIGINTs: the distinct values of each att set, where
+    //    pruned (NULL) rows are unique values
 
     duckdb::UnifiedVectorFormat sdata;
     stateVector.ToUnifiedFormat(count, sdata);
@@ -100,33 +124,66 @@ static void sumDictFinalize(duckdb::Vector &stateVector, duckdb::AggregateInputD
     // Create result value containers
     duckdb::vector<duckdb::Value> unprunedVals;
     duckdb::vector<duckdb::Value> entropies;
+    duckdb::vector<duckdb::Value> distinctCounts;
+
+    // Survivors to register in the object cache, if sum_dict was given a key
+    auto &bindData = aggrInputData.bind_data->Cast<SumDictBindData>();
+    duckdb::shared_ptr<survivorCache::SurvivorEntry> survivors;
+    if (!bindData.key.empty()) {
+        survivors = duckdb::make_shared_ptr<survivorCache::SurvivorEntry>();
+        survivors->sets.resize(resultCount);
+        survivors->rowCounts.resize(resultCount);
+    }
 
-    // Find N (number of records) from first map to allow pruning
-    auto N = 0;
-    for (const auto& [k, v] : state.maps[0]) {
-        N += v;
+    // Rows aggregated, pruned ones included
+    if (survivors) {
+        survivors->tupleCount = state.rows;
     }
 
     // Iterate through att. sets
     for (idx_t i = 0; i < resultCount; i++) {
-        if (state.maps[i].size() == N) {
-            // Entire dist. is unique, skip
+        int64_t counted = 0;
+        for (const auto& [k, v] : state.maps[i]) {
+            counted += v;
+        }
+        distinctCounts.push_back(duckdb::Value::UBIGINT(state.maps[i].size() + (state.rows - counted)));
+
+        if ((int64_t) state.maps[i].size() == counted) {
+            // Every live (unpruned) value is unique: nothing survives, skip
             entropies.push_back(duckdb::Value::DOUBLE(0));
             unprunedVals.push_back(duckdb::Value::LIST(duckdb::LogicalType::UBIGINT, {}));
             continue;
         } 
 
         // Calculate entropy and prune unique values from remaining dist
+        // (map iteration is in hash order, so survivors come out sorted)
         double entropy = 0.0;
-        duckdb::vector<duckdb::Value> unpruned;
+        std::vector<hash_t> sortedUnpruned;
         for (const auto& [k, v] : state.maps[i]) {
             entropy += (double) v * std::log2((double) v);
             if (v > 1) {
-                unpruned.push_back(duckdb::Value::UBIGINT(k));
+                sortedUnpruned.push_back(k);
+                if (survivors) {
+                    survivors->rowCounts[i] += v;
+                }
             }
         }
         entropies.push_back(duckdb::Value::DOUBLE(entropy));
+
+        // Survivors are stored in Eytzinger order for branchless probing in filt
+        auto tree = eytzinger::build(sortedUnpruned);
+        duckdb::vector<duckdb::Value> unpruned;
+        for (const auto& hash : tree) {
+            unpruned.push_back(duckdb::Value::UBIGINT(hash));
+        }
         unprunedVals.push_back(duckdb::Value::LIST(duckdb::LogicalType::UBIGINT, unpruned));
+        if (survivors) {
+            survivors->sets[i] = std::move(tree);
+        }
+    }
+
+    if (survivors) {
+        survivorCache::registerSurvivors(*bindData.cache, bindData.key, std::move(survivors));
     }
 
     // Create struct result
@@ -135,6 +192,7 @@ static void sumDictFinalize(duckdb::Vector &stateVector, duckdb::AggregateInputD
     // Specify types explicitly in case the lists are empty
     structValues.push_back(make_pair("sets", duckdb::Value::LIST(duckdb::LogicalType::LIST(duckdb::LogicalType::UBIGINT), unprunedVals)));
     structValues.push_back(make_pair("entropies", duckdb::Value::LIST(duckdb::LogicalType::DOUBLE, entropies)));
+    structValues.push_back(make_pair("distinct_counts", duckdb::Value::LIST(duckdb::LogicalType::UBIGINT, distinctCounts)));
 
     result.SetValue(0, duckdb::Value::STRUCT(structValues));
 }
@@ -143,10 +201,18 @@ duckdb::unique_ptr<duckdb::FunctionData> sumDictBind(duckdb::ClientContext &cont
     duckdb::vector<std::pair<std::string, duckdb::LogicalType>> structTypes;
     structTypes.push_back(std::make_pair("sets", duckdb::LogicalType::LIST(duckdb::LogicalType::LIST(duckdb::LogicalType::UBIGINT))));
     structTypes.push_back(std::make_pair("entropies", duckdb::LogicalType::LIST(duckdb::LogicalType::DOUBLE)));
+    structTypes.push_back(std::make_pair("distinct_counts", duckdb::LogicalType::LIST(duckdb::LogicalType::UBIGINT)));
 
     auto resultType = duckdb::LogicalType::STRUCT(structTypes);
     function.return_type = resultType;
-    return duckdb::make_uniq<duckdb::VariableReturnBindData>(function.return_type);
+    return duckdb::make_uniq<SumDictBindData>();
+}
+
+// sum_dict(hashes, key): additionally register the survivors under key for filt lookups
+duckdb::unique_ptr<duckdb::FunctionData> sumDictCachedBind(duckdb::ClientContext &context, duckdb::AggregateFunction &function, duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> &arguments) {
+    sumDictBind(context, function, arguments);
+    auto key = survivorCache::bindConstant(context, *arguments[1], "key").ToString();
+    return duckdb::make_uniq<SumDictBindData>(key, &survivorCache::getCache(context));
 }
 
 } // namespace sumDict
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "duckdb.hpp"
+#include "duckdb/storage/object_cache.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/*
+Registry of previous-layer survivors kept in the database's ObjectCache.
+sum_dict(..., key) registers the non-unique hashes of each att. set under key and
+filt(hash, key, offset) looks them up, so the survivors never travel as a column.
+A layer computed in batches registers each batch under its own key and
+merge_survivors joins them back into one entry.
+*/
+
+namespace survivorCache {
+
+using hash_t = uint64_t;
+
+struct SurvivorEntry : public duckdb::ObjectCacheEntry {
+    // For each att. set (in layer order), its non-unique hashes in Eytzinger order
+    std::vector<std::vector<hash_t>> sets;
+    // For each att. set, the number of tuples carrying one of its survivors
+    std::vector<int64_t> rowCounts;
+    // Tuples counted by the layer (N in sum_dict)
+    int64_t tupleCount = 0;
+
+    // Fraction of tuples passing set i's filter, as seen by the layer that built it
+    double passRate(idx_t i) const {
+        if (tupleCount <= 0) {
+            return 1.0;
+        }
+        return std::min(1.0, (double) rowCounts[i] / tupleCount);
+    }
+
+    static std::string ObjectType() {
+        return "quack_survivors";
+    }
+
+    std::string GetObjectType() override {
+        return ObjectType();
+    }
+};
+
+duckdb::ObjectCache& getCache(duckdb::ClientContext &context) {
+    return duckdb::DatabaseInstance::GetDatabase(context).GetObjectCache();
+}
+
+void registerSurvivors(duckdb::ObjectCache &cache, const std::string &key, duckdb::shared_ptr<SurvivorEntry> entry) {
+    // Put doesn't overwrite existing keys
+    cache.Delete(key);
+    cache.Put(key, std::move(entry));
+}
+
+duckdb::shared_ptr<SurvivorEntry> lookupSurvivors(duckdb::ClientContext &context, const std::string &key) {
+    auto entry = getCache(context).Get<SurvivorEntry>(key);
+    if (!entry) {
+        throw duckdb::BinderException("No survivors registered under key '%s'", key);
+    }
+    return entry;
+}
+
+// Evaluate a constant argument (e.g. a layer key or set offset) at bind time
+duckdb::Value bindConstant(duckdb::ClientContext &context, duckdb::Expression &arg, const std::string &name) {
+    // Prepared statement parameters are rebound as constants once their values are known
+    if (arg.HasParameter()) {
+        throw duckdb::ParameterNotResolvedException();
+    }
+    if (!arg.IsFoldable()) {
+        throw duckdb::BinderException("Argument '%s' must be a constant", name);
+    }
+    return duckdb::ExpressionExecutor::EvaluateScalar(context, arg);
+}
+
+// drop_survivors(key): release a layer once no later query needs it
+struct DropBindData : public duckdb::FunctionData {
+    duckdb::ObjectCache &cache;
+    std::string key;
+
+    DropBindData(duckdb::ObjectCache &cache, std::string key) : cache(cache), key(std::move(key)) {}
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<DropBindData>(cache, key);
+    }
+
+    bool Equals(const duckdb::FunctionData &other) const override {
+        return key == other.Cast<DropBindData>().key;
+    }
+};
+
+duckdb::unique_ptr<duckdb::FunctionData> dropSurvivorsBind(duckdb::ClientContext &context, duckdb::ScalarFunction &function, duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> &arguments) {
+    auto key = bindConstant(context, *arguments[0], "key").ToString();
+    return duckdb::make_uniq<DropBindData>(getCache(context), key);
+}
+
+void dropSurvivorsFunction(duckdb::DataChunk &args, duckdb::ExpressionState &state, duckdb::Vector &result) {
+    auto &bindData = state.expr.Cast<duckdb::BoundFunctionExpression>().bind_info->Cast<DropBindData>();
+    bool existed = bindData.cache.Get<SurvivorEntry>(bindData.key) != nullptr;
+    bindData.cache.Delete(bindData.key);
+
+    result.SetVectorType(duckdb::VectorType::CONSTANT_VECTOR);
+    duckdb::ConstantVector::GetData<bool>(result)[0] = existed;
+}
+
+// merge_survivors(key, parts): register the concatenation of the survivors under
+// parts (batches of one layer, in order) as key and release the parts
+struct MergeBindData : public duckdb::FunctionData {
+    duckdb::ObjectCache &cache;
+    std::string key;
+    std::vector<std::string> parts;
+
+    MergeBindData(duckdb::ObjectCache &cache, std::string key, std::vector<std::string> parts) :
+        cache(cache), key(std::move(key)), parts(std::move(parts)) {}
+
+    duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+        return duckdb::make_uniq<MergeBindData>(cache, key, parts);
+    }
+
+    bool Equals(const duckdb::FunctionData &other) const override {
+        auto &otherData = other.Cast<MergeBindData>();
+        return key == otherData.key && parts == otherData.parts;
+    }
+};
+
+duckdb::unique_ptr<duckdb::FunctionData> mergeSurvivorsBind(duckdb::ClientContext &context, duckdb::ScalarFunction &function, duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> &arguments) {
+    auto key = bindConstant(context, *arguments[0], "key").ToString();
+    std::vector<std::string> parts;
+    for (const auto& part : duckdb::ListValue::GetChildren(bindConstant(context, *arguments[1], "parts"))) {
+        parts.push_back(part.ToString());
+    }
+    return duckdb::make_uniq<MergeBindData>(getCache(context), key, std::move(parts));
+}
+
+void mergeSurvivorsFunction(duckdb::DataChunk &args, duckdb::ExpressionState &state, duckdb::Vector &result) {
+    auto &bindData = state.expr.Cast<duckdb::BoundFunctionExpression>().bind_info->Cast<MergeBindData>();
+
+    auto merged = duckdb::make_shared_ptr<SurvivorEntry>();
+    for (const auto& part : bindData.parts) {
+        auto entry = bindData.cache.Get<SurvivorEntry>(part);
+        if (!entry) {
+            throw duckdb::InvalidInputException("No survivors registered under key '%s'", part);
+        }
+        merged->sets.insert(merged->sets.end(), entry->sets.begin(), entry->sets.end());
+        merged->rowCounts.insert(merged->rowCounts.end(), entry->rowCounts.begin(), entry->rowCounts.end());
+        merged->tupleCount = std::max(merged->tupleCount, entry->tupleCount);
+    }
+    for (const auto& part : bindData.parts) {
+        bindData.cache.Delete(part);
+    }
+    registerSurvivors(bindData.cache, bindData.key, std::move(merged));
+
+    result.SetVectorType(duckdb::VectorType::CONSTANT_VECTOR);
+    duckdb::ConstantVector::GetData<bool>(result)[0] = true;
+}
+
+} // namespace survivorCache
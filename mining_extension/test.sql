@@ -80,3 +80,96 @@ CREATE TABLE l2 AS SELECT ([
 
 ]) AS out
 FROM tbl, l1;
+
+
+-- Survivors registered in the object cache (no cross join with l1)
+CREATE OR REPLACE TABLE l1 AS SELECT sum_dict([
+    hash_list([col0]), -- A
+    hash_list([col1]), -- B
+    hash_list([col2])  -- C
+], 'l1') AS out
+FROM tbl;
+
+CREATE OR REPLACE TABLE l2 AS SELECT sum_dict([
+    -- AB
+    CASE
+        WHEN filt(hash_list([col0]), 'l1', 0) AND
+             filt(hash_list([col1]), 'l1', 1)
+        THEN hash_list([col0, col1])
+        ELSE NULL
+    END,
+    -- AC
+    CASE
+        WHEN filt(hash_list([col0]), 'l1', 0) AND
+             filt(hash_list([col2]), 'l1', 2)
+        THEN hash_list([col0, col2])
+        ELSE NULL
+    END,
+    -- BC
+    CASE
+        WHEN filt(hash_list([col1]), 'l1', 1) AND
+             filt(hash_list([col2]), 'l1', 2)
+        THEN hash_list([col1, col2])
+        ELSE NULL
+    END
+], 'l2') AS out
+FROM tbl;
+SELECT drop_survivors('l1');
+
+-- Fused pruning + hashing: one list entry per 2-set (AB, AC, BC)
+CREATE OR REPLACE TABLE l1 AS SELECT sum_dict([
+    hash_list([col0]),
+    hash_list([col1]),
+    hash_list([col2])
+], 'l1') AS out
+FROM tbl;
+SELECT hash_if_alive('l1', 2, col0, col1, col2) FROM tbl;
+-- Same, with the layer layouts given explicitly (only AB and BC are candidates)
+SELECT hash_if_alive('l1', [[0], [1], [2]], [[0, 1], [1, 2]], col0, col1, col2) FROM tbl;
+
+-- Whole lattice mined natively; every row also carries the number of rows mined
+SELECT * FROM mine_entropies('tbl');
+SELECT * FROM mine_entropies('tbl', 'col0', 'col2');
+
+-- Entropy store: written once mining finishes, read back without re-mining
+SELECT * FROM mine_entropies('tbl', store := 'entropies.store');
+SELECT * FROM read_entropies('entropies.store');
+
+-- Layers counted in passes of at most 64MB of count tables
+SELECT * FROM mine_entropies('tbl', memory_budget := '64MB');
+
+-- Only the 1- and 2-sets
+SELECT * FROM mine_entropies('tbl', max_layer := 2);
+
+-- Stop after the first layer that ends past 10 seconds or 8GB of peak memory
+SELECT * FROM mine_entropies('tbl', time_budget := 10, peak_memory_budget := '8GB');
+
+-- Mined straight from a file: layer 1 is counted while the CSV is parsed and
+-- later layers reuse the column hashes kept by that scan
+SELECT * FROM mine_entropies('read_csv(''test.csv'')', encode := true);
+
+-- Row hashes of typed columns, equal to hash_list of the same values
+CREATE TABLE typed(a INTEGER, b DATE, c VARCHAR);
+INSERT INTO typed VALUES (1, DATE '2024-01-01', 'x'), (2, NULL, 'y');
+SELECT hash_row(a, b, c), hash_row(c), hash_list([c]) FROM typed;
+
+-- Only cell hashes kept: same entropies as mining tbl, barring hash collisions
+CREATE TABLE tbl_hashed AS SELECT hash(col0) AS col0, hash(col1) AS col1, hash(col2) AS col2 FROM read_csv('test.csv', header=false);
+SELECT * FROM mine_entropies('tbl_hashed');
+
+-- A dataset cached by the driver (main <dataset> --cache test.encoded), scanned in place
+SELECT * FROM mine_entropies('read_encoded(''test.encoded'')');
+
+-- Layer 2 from sum_dict agrees with mine_entropies (H = log2(N) - sum / N); the
+-- pruned (NULL) rows of the first set must not be mistaken for a key
+CREATE OR REPLACE TABLE l1 AS SELECT sum_dict([hash_row(col0), hash_row(col1), hash_row(col2)], 'l1') AS out FROM tbl;
+WITH l2 AS (
+    SELECT sum_dict(hash_if_alive('l1', [[0], [1], [2]], [[0, 1], [0, 2], [1, 2]], col0, col1, col2)) AS out, count(*) AS n FROM tbl
+), layer AS (
+    SELECT UNNEST([['col0', 'col1'], ['col0', 'col2'], ['col1', 'col2']]) AS attribute_set,
+           UNNEST(out.entropies) AS sum, UNNEST(out.distinct_counts) AS distinct_count, n FROM l2
+)
+SELECT layer.attribute_set, abs(log2(n) - sum / n - mined.entropy) < 1e-9 AS entropy_matches,
+       layer.distinct_count = mined.distinct_count AS distinct_matches
+FROM layer JOIN mine_entropies('tbl', max_layer := 2) AS mined USING (attribute_set);
+SELECT drop_survivors('l1');
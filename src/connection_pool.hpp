@@ -0,0 +1,119 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+/*
+    A fixed number of worker threads, each with its own connection to the same
+    database, taking queries off a shared work queue. The number of workers is
+    the concurrency limit: at most that many submitted tasks run at once.
+*/
+class ConnectionPool {
+public:
+    using Task = std::function<void(duckdb::Connection&)>;
+
+private:
+    std::vector<std::unique_ptr<duckdb::Connection>> connections;
+    std::vector<std::thread> workers;
+
+    std::mutex lock;
+    std::condition_variable taskReady;
+    std::condition_variable tasksDone;
+    std::deque<Task> queue;
+    int active = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    void work(duckdb::Connection& conn) {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                taskReady.wait(guard, [&] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                task = std::move(queue.front());
+                queue.pop_front();
+                active++;
+            }
+
+            try {
+                task(conn);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            active--;
+            if (queue.empty() && active == 0) {
+                tasksDone.notify_all();
+            }
+        }
+    }
+
+public:
+    // setup runs once on every connection before it takes tasks (e.g. to set options)
+    ConnectionPool(duckdb::DuckDB& db, int size, const Task& setup = nullptr) {
+        for (int i = 0; i < size; i++) {
+            connections.push_back(std::make_unique<duckdb::Connection>(db));
+            if (setup) {
+                setup(*connections.back());
+            }
+        }
+        for (auto& conn : connections) {
+            workers.emplace_back(&ConnectionPool::work, this, std::ref(*conn));
+        }
+    }
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    ~ConnectionPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        taskReady.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    int size() const {
+        return workers.size();
+    }
+
+    void submit(Task task) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            queue.push_back(std::move(task));
+        }
+        taskReady.notify_one();
+    }
+
+    /*
+        Block until every submitted task has finished. Rethrows the first
+        exception a task threw.
+    */
+    void wait() {
+        std::unique_lock<std::mutex> guard(lock);
+        tasksDone.wait(guard, [&] { return queue.empty() && active == 0; });
+        if (error) {
+            auto taskError = error;
+            error = nullptr;
+            std::rethrow_exception(taskError);
+        }
+    }
+};
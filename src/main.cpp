@@ -1,249 +1,246 @@
-#include "duckdb.hpp"
+#include "schema_miner.hpp"
 
 #include <iostream>
 #include <string>
-#include <set>
-#include <vector>
 #include <map>
+#include <sstream>
 #include <chrono>
-#include <functional>
 
-using AttributeSet = std::set<int>;
-
-class SchemaMiner {
-private:
-    static duckdb::DBConfig* initConfig() {
-        auto config = new duckdb::DBConfig();
-        config->options.allow_unsigned_extensions = true;
-        return config;
-    }
-
-protected:
-    // DB
-    duckdb::DuckDB db;
-    duckdb::Connection conn;
-
-    // Relation info 
-    std::string csvPath;
-    int attributeCount;
-    long tupleCount;
-
-    // Entropies 
-    std::map<AttributeSet, double> entropies;
-
-public:
-    SchemaMiner(std::string csvPath, int attributeCount) : 
-        csvPath(csvPath),
-        attributeCount(attributeCount),
-        db(nullptr, initConfig()),
-        conn(db) {
-
-        // Load extension and CSV
-        loadExtension();
-        loadCSV();
+/*
+    Usage: main <dataset path> [options]
+
+    The dataset is a header-less CSV file, or a Parquet file (.parquet). A glob
+    (quoted, e.g. 'exports/day-*.csv') mines all matching files as one dataset.
+
+    --columns N          number of CSV columns (default: sniffed from the file)
+    --select A,B,...     columns to mine, by name (CSV columns are col0, col1, ...)
+    --all-varchar        mine every column as VARCHAR instead of keeping its type
+    --hash-cells         load a 64-bit hash per cell instead of the values (smaller and
+                         faster to scan, but colliding values are counted as one)
+    --cache PATH         keep the cell hashes in PATH and reuse them while the dataset
+                         is unchanged (implies --hash-cells)
+    --strategy NAME      filt, semi-join, registry, fused, native or streaming
+                         (default: filt)
+    --threads N          DuckDB worker threads (default: all cores)
+    --memory-limit SIZE  DuckDB memory_limit and layer memory budget, e.g. 8GB
+    --max-layer N        largest attribute set size to mine (default: all)
+    --time-budget SECS   stop after the first layer that ends past SECS seconds
+    --memory-budget SIZE stop after the first layer that leaves peak memory above SIZE, e.g. 16GB
+    --concurrency N      layer batches run at once, on separate connections (default: 1)
+    --load-concurrency N glob datasets: file groups loaded at once (default: one per core)
+    --sample-rows N      estimate each layer on a reservoir sample of N rows first, to size
+                         and order its batches and only verify likely keys
+    --database PATH      keep tbl and the layer tables in a database file instead of in
+                         memory, so they can spill to disk (in the schema_miner schema,
+                         which is dropped first)
+    --temp-directory DIR where DuckDB spills data that exceeds the memory limit
+    --extension PATH     mining extension to load
+    --output PATH        where to write the entropies (default: ./entropies.store,
+                         or ./entropies.parquet with --output-format parquet)
+    --output-format F    store (memory-mappable entropy store, checkpointed after
+                         every layer), parquet or none (default: store)
+    --print-layers       print every layer table while mining (debugging)
+*/
+
+struct Options {
+    std::string datasetPath;
+    int columns = 0;
+    std::vector<std::string> select;
+    bool allVarchar = false;
+    bool hashCells = false;
+    std::string cachePath;
+    PruneStrategy strategy = PruneStrategy::Filt;
+    int threads = 0;
+    std::string memoryLimit;
+    int maxLayer = 0;
+    int timeBudget = 0;
+    std::string peakMemoryBudget;
+    int concurrency = 1;
+    int sampleRows = 0;
+    int loadConcurrency = 0;
+    std::string databasePath;
+    std::string tempDirectory;
+    std::string extensionPath = SchemaMiner::DEFAULT_EXTENSION_PATH;
+    std::string outputPath;
+    OutputSink outputSink = OutputSink::Store;
+    bool printLayers = false;
+};
 
-        computeEntropiesWithPruning();
+[[noreturn]] void usage(const std::string& program, const std::string& error = "") {
+    if (!error.empty()) {
+        std::cerr << "\033[1;31m" << error << "\033[0m\n";
     }
-
-    void loadExtension() {
-        std::string loadQry = "LOAD './mining_extension/build/release/extension/quack/quack.duckdb_extension';";
-
-        auto loadResult = conn.Query(loadQry);
-
-        if (loadResult->HasError()) {
-            std::string loadErrMsg = "\033[1;31mFailed to load mining extension: \033[0m";
-            std::cerr << loadErrMsg << loadResult->ToString();
-            exit(1);
+    std::cerr << "Usage: " << program << " <dataset path> [--columns N] [--select A,B,...]\n"
+              << "       [--all-varchar] [--hash-cells] [--cache PATH]\n"
+              << "       [--strategy filt|semi-join|registry|fused|native|streaming]\n"
+              << "       [--threads N] [--memory-limit SIZE] [--max-layer N] [--time-budget SECS]\n"
+              << "       [--memory-budget SIZE] [--concurrency N] [--sample-rows N]\n"
+              << "       [--load-concurrency N] [--database PATH] [--temp-directory DIR]\n"
+              << "       [--extension PATH] [--output PATH] [--output-format store|parquet|none]\n"
+              << "       [--print-layers]\n";
+    exit(error.empty() ? 0 : 1);
+}
+
+int parsePositive(const std::string& program, const std::string& flag, const std::string& value) {
+    try {
+        size_t end;
+        int number = std::stoi(value, &end);
+        if (end == value.size() && number > 0) {
+            return number;
         }
+    } catch (std::exception&) {
     }
-
-    void loadCSV() {
-        std::string loadQry = "CREATE TABLE tbl AS SELECT * FROM read_csv('" + csvPath + "', header=false, columns={";
-        for (int i = 0; i < attributeCount; i++) {
-            loadQry += "'col" + std::to_string(i) + "': 'VARCHAR'";
-            if (i != attributeCount - 1) {
-                loadQry += ",";
-            }
+    usage(program, flag + " expects a positive integer, got '" + value + "'");
+}
+
+Options parseOptions(int argc, char* argv[]) {
+    const std::map<std::string, PruneStrategy> strategies = {
+        {"filt", PruneStrategy::Filt},
+        {"semi-join", PruneStrategy::SemiJoin},
+        {"registry", PruneStrategy::Registry},
+        {"fused", PruneStrategy::Fused},
+        {"native", PruneStrategy::Native},
+        {"streaming", PruneStrategy::Streaming}
+    };
+    const std::map<std::string, OutputSink> sinks = {
+        {"store", OutputSink::Store},
+        {"parquet", OutputSink::Parquet},
+        {"none", OutputSink::None}
+    };
+
+    std::string program = argv[0];
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage(program);
         }
-        loadQry += "});";
-        conn.Query(loadQry);
-    }
-
-    std::map<AttributeSet, double> getEntropies() {
-        return entropies;
-    }
-
-    /*
-        This method prunes entire attribute sets where possible but doesn't 
-        prune individual tuples.
-    */
-    void computeEntropiesPruneSets() {
-        std::string computeQry = "SELECT prune(custom_sum(lift_exact([";
-        for (int i = 0; i < attributeCount; i++) {
-            computeQry += "col" + std::to_string(i);
-            if (i != attributeCount - 1) {
-                computeQry += ", ";
+        if (arg.rfind("--", 0) != 0) {
+            if (!options.datasetPath.empty()) {
+                usage(program, "Unexpected argument '" + arg + "'");
             }
+            options.datasetPath = arg;
+            continue;
         }
-        computeQry += "]))) FROM tbl;";
-        bool hasResults = true;
-
-        while (hasResults) {
-            auto entropiesResult = conn.Query(computeQry);
-            auto map = entropiesResult->GetValue(0, 0);
-            auto entryCount = duckdb::MapValue::GetChildren(map).size();
-
-            hasResults = entryCount > 0;
+        if (arg == "--all-varchar") {
+            options.allVarchar = true;
+            continue;
         }
-    }
-
-    /*
-        Generate all n-set combinations of attributes.
-    */
-    std::vector<std::vector<int>> getAttributeCombinations(int n) {
-        std::vector<std::vector<int>> combinations;
-        std::vector<int> stack;
-
-        std::function<void(int, int)> generateCombinations = [&](int start, int k) {
-            if (k == 0) {
-                combinations.push_back(stack);
-                return;
-            }
-
-            for (int i = start; i <= attributeCount - k; i++) {
-                stack.push_back(i);
-                generateCombinations(i + 1, k - 1);
-                stack.pop_back();
-            }
-        };
-
-        generateCombinations(0, n);
-        return combinations;
-    }
-
-    std::vector<std::vector<int>> getSubsets(std::vector<int> attSet) {
-        int n = attSet.size();
-        std::vector<std::vector<int>> subsets(n);
-        for (int i = 0; i < attSet.size(); i++) {
-            std::vector<int> subset;
-            for (int j = 0; j < attSet.size(); j++) {
-                if (j != i) {
-                    subset.push_back(attSet[j]);
-                }
-            }
-            subsets[n - i - 1] = subset;
+        if (arg == "--hash-cells") {
+            options.hashCells = true;
+            continue;
         }
-        return subsets;
-    }
-
-    /*
-        Compute entropies for all 1-sets in a single query and make resulting table
-    */
-    void computeFirstLayer() {
-        std::string qry = "CREATE TABLE l1 AS SELECT sum_dict([\n";
-        for (int i = 0; i < attributeCount; i++) {
-            qry += "\thash_list([col" + std::to_string(i) + "]),\n";
+        if (arg == "--print-layers") {
+            options.printLayers = true;
+            continue;
         }
-        qry.resize(qry.size() - 2); // Remove last comma and newline
-        qry += "]) AS out\nFROM tbl;";
-
-        conn.Query(qry);
-        conn.Query("SELECT * FROM l1;")->Print();
-    }
-
-    /*
-        Compute entropies for all n-sets in a single query.
-        Assume that the previous layer query has been executed and stored in the table l[n-1]
-        and original relation is stored in tbl.
-
-        Returns 1 if at least one valid n-set is found, 0 otherwise. 
-    */
-    int computeSingleLayer(int n) {
-        // TODO: Store combinations / previous combinations as class members
-        // avoids regeneration and allows easy saving of entropies
-        // TODO: Save entropies
-        auto attSets = getAttributeCombinations(n);
-        auto prevAttSets = getAttributeCombinations(n - 1);
-
-        // Map previous sets to their position in l[n-1].out.sets
-        std::map<std::vector<int>, int> prevIndexMap;
-        for (int i = 0; i < prevAttSets.size(); i++) {
-            prevIndexMap[prevAttSets[i]] = i;
+        if (i + 1 == argc) {
+            usage(program, arg + " expects a value");
         }
 
-        std::string qry = "CREATE TABLE l" + std::to_string(n) + " AS SELECT sum_dict([\n";
-        for (auto& atts : attSets) {
-            qry += "\tCASE\n\t\tWHEN ";
-
-            std::vector<std::vector<int>> subsets = getSubsets(atts);
-
-            // Iterate through atts. and remove 1 by 1 to create filtering conditions
-            for (const auto& subset : subsets) {
-                int offset = prevIndexMap[subset];
-                qry += "filt(hash_list([";
-                for (const auto& att : subset) {
-                    qry += "col" + std::to_string(att);
-                    if (att != subset.back()) {
-                        qry += ", ";
-                    }
-                }
-                qry += "]), l" + std::to_string(n - 1) + ".out.sets, " + std::to_string(offset) + ") AND\n\t\t\t";
+        std::string value = argv[++i];
+        if (arg == "--columns") {
+            options.columns = parsePositive(program, arg, value);
+        } else if (arg == "--select") {
+            std::stringstream names(value);
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                options.select.push_back(name);
             }
-
-            qry.resize(qry.size() - 7); // Remove last AND\n\t\t\t
-
-            qry += "\n\t\tTHEN hash_list([";
-            for (const auto& att : atts) {
-                qry += "col" + std::to_string(att) + ",";
+        } else if (arg == "--cache") {
+            options.cachePath = value;
+        } else if (arg == "--strategy") {
+            auto strategy = strategies.find(value);
+            if (strategy == strategies.end()) {
+                usage(program, "Unknown strategy '" + value + "'");
             }
-            qry.resize(qry.size() - 1); // Remove last comma
-            qry += "])\n\t\tELSE NULL\n\tEND,\n";
-        }
-        qry.resize(qry.size() - 2); // Remove last comma and newline
-
-        qry += "]) AS out\nFROM tbl, l" + std::to_string(n - 1) + ";";
-        
-        //std::cout << qry << "\n\n";
-        conn.Query(qry);
-        conn.Query("SELECT * FROM l" + std::to_string(n) + ";")->Print();
-
-        // Check for non-zero entropies 
-        auto entropyResult = conn.Query("SELECT out.entropies FROM l" + std::to_string(n) + ";");
-        auto entropyList = entropyResult->GetValue(0, 0);
-        for (const auto& entropy : duckdb::ListValue::GetChildren(entropyList)) {
-            if (entropy.GetValue<int>() != 0) {
-                return 1;
+            options.strategy = strategy->second;
+        } else if (arg == "--threads") {
+            options.threads = parsePositive(program, arg, value);
+        } else if (arg == "--memory-limit") {
+            options.memoryLimit = value;
+        } else if (arg == "--max-layer") {
+            options.maxLayer = parsePositive(program, arg, value);
+        } else if (arg == "--time-budget") {
+            options.timeBudget = parsePositive(program, arg, value);
+        } else if (arg == "--memory-budget") {
+            options.peakMemoryBudget = value;
+        } else if (arg == "--concurrency") {
+            options.concurrency = parsePositive(program, arg, value);
+        } else if (arg == "--load-concurrency") {
+            options.loadConcurrency = parsePositive(program, arg, value);
+        } else if (arg == "--sample-rows") {
+            options.sampleRows = parsePositive(program, arg, value);
+        } else if (arg == "--database") {
+            options.databasePath = value;
+        } else if (arg == "--temp-directory") {
+            options.tempDirectory = value;
+        } else if (arg == "--extension") {
+            options.extensionPath = value;
+        } else if (arg == "--output") {
+            options.outputPath = value;
+        } else if (arg == "--output-format") {
+            auto sink = sinks.find(value);
+            if (sink == sinks.end()) {
+                usage(program, "Unknown output format '" + value + "'");
             }
+            options.outputSink = sink->second;
+        } else {
+            usage(program, "Unknown option '" + arg + "'");
         }
+    }
 
-        return 0;
+    if (options.datasetPath.empty()) {
+        usage(program, "Missing dataset path");
+    }
+    if (options.outputPath.empty()) {
+        options.outputPath = options.outputSink == OutputSink::Parquet ? "./entropies.parquet" : "./entropies.store";
     }
+    return options;
+}
 
-    /*
-        Compute entropies for all set (unless no n-sets are found) at which point we stop
-        and prune individual tuples at each stage.
-    */
-    void computeEntropiesWithPruning() {
-        computeFirstLayer();
-
-        int layer = 2;
-        while (layer <= attributeCount) {
-            if (!computeSingleLayer(layer)) {
-                // No valid n-sets found, stop
-                break;
-            }
-            layer++;
+int main(int argc, char* argv[]) {
+    auto options = parseOptions(argc, argv);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto source = MiningSource::file(options.datasetPath, options.select);
+    source.csvColumnCount = options.columns;
+    source.preserveTypes = !options.allVarchar;
+    source.hashCells = options.hashCells;
+    source.cachePath = options.cachePath;
+    source.loadConcurrency = options.loadConcurrency;
+    DatabaseOptions database;
+    database.path = options.databasePath;
+    database.threads = options.threads;
+    database.memoryLimit = options.memoryLimit;
+    database.tempDirectory = options.tempDirectory;
+    SchemaMiner sm(source, options.strategy, options.extensionPath, database);
+    if (!options.peakMemoryBudget.empty()) {
+        try {
+            sm.setPeakMemoryBudget(duckdb::DBConfig::ParseMemoryLimit(options.peakMemoryBudget));
+        } catch (std::exception&) {
+            usage(argv[0], "Invalid memory budget '" + options.peakMemoryBudget + "'");
         }
     }
-};
+    sm.setMaxLayer(options.maxLayer);
+    sm.setTimeBudget(std::chrono::seconds(options.timeBudget));
+    sm.setConcurrency(options.concurrency);
+    sm.setSampleRows(options.sampleRows);
+    sm.setPrintLayers(options.printLayers);
+    if (options.outputSink == OutputSink::Store) {
+        // Keep every completed layer if the run is killed
+        sm.setCheckpointPath(options.outputPath);
+    }
 
-int main() {
-    auto start = std::chrono::high_resolution_clock::now();
-    SchemaMiner sm("./dataviz/datasets/small_flights.csv", 19);
+    auto report = sm.computeEntropiesWithPruning();
+    sm.writeOutput(options.outputSink, options.outputPath);
     auto end = std::chrono::high_resolution_clock::now();
 
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     std::cout << "Runtime: " << duration.count() << "ms\n";
+    sm.printReport(report);
+    sm.printLayerTimings();
 
-    return 0;
-}
\ No newline at end of file
+    // The complete layers are written, but a failed layer fails the run
+    return report.reason == StopReason::Failed ? 1 : 0;
+}
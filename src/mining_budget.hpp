@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "peak_memory.hpp"
+
+/*
+    Why mining stopped. Budgets are checked between layers, so every layer up to
+    the one that exceeded a budget is complete.
+*/
+enum class StopReason {
+    Exhausted,
+    MaxLayer,
+    Deadline,
+    Memory,
+    // A layer's query failed (e.g. out of memory); that layer isn't complete
+    Failed
+};
+
+inline std::string stopReasonName(StopReason reason) {
+    switch (reason) {
+        case StopReason::Exhausted: return "lattice exhausted";
+        case StopReason::MaxLayer: return "max layer reached";
+        case StopReason::Deadline: return "deadline reached";
+        case StopReason::Memory: return "memory budget exceeded";
+        case StopReason::Failed: return "layer query failed";
+    }
+    return "";
+}
+
+struct MiningReport {
+    StopReason reason = StopReason::Exhausted;
+    // Layers 1..completeLayers hold every candidate set of their size. When the
+    // lattice is exhausted, larger sets are all supersets of keys.
+    int completeLayers = 0;
+    // Sets mined per layer, indexed by layer
+    std::vector<uint64_t> layerSetCounts;
+    double seconds = 0;
+    uint64_t peakMemory = 0;
+    // Why the layer after the complete ones failed (Failed only)
+    std::string error;
+};
+
+using lattice::peakMemoryBytes;
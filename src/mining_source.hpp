@@ -0,0 +1,141 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+namespace duckdb {
+struct ArrowStreamParameters;
+}
+
+/*
+    Where the mined relation comes from: a header-less CSV file, a Parquet file
+    or an in-process Arrow stream. Mined columns are chosen by name (CSV columns
+    are named col0, col1, ...) and become attributes 0, 1, ... in that order.
+    A file path may be a glob (e.g. exports/day-*.csv) matching files of the
+    same layout, which are mined as one relation.
+*/
+enum class SourceFormat {
+    CSV,
+    Parquet,
+    Arrow
+};
+
+struct MiningSource {
+    SourceFormat format = SourceFormat::CSV;
+    std::string path;
+    // Consumed by the first scan of the source
+    ArrowArrayStream* arrowStream = nullptr;
+    // Columns to mine ({}: all of them)
+    std::vector<std::string> columns;
+    // CSV only: number of columns in the file (0: sniffed)
+    int csvColumnCount = 0;
+    // Keep column types that compare like their VARCHAR form (false: all VARCHAR)
+    bool preserveTypes = true;
+    /*
+        Load only a 64-bit hash of every cell (into tbl_hashed), computed while the
+        source is scanned, and never the values themselves. Layer scans then read
+        fixed-width UBIGINTs instead of strings, and wide text tables shrink to 8
+        bytes per cell. The tradeoff: two distinct values of a column whose hashes
+        collide are counted as one, so an entropy can come out too low and a
+        near-key can be reported as a key. Set hashes are already 64-bit, so this
+        only adds the per-column chance of a collision (about d^2 / 2^65 for d
+        distinct values), but results are no longer verified against the values.
+    */
+    bool hashCells = false;
+    /*
+        Encoded dataset file caching the cell hashes across runs ("": none). A cache
+        whose key matches the source file and ingest options is scanned in place
+        (read_encoded) instead of reading the file; otherwise it is rewritten after
+        loading. Implies hashCells. Not used for globs, Arrow streams or streaming
+        mining.
+    */
+    std::string cachePath;
+    // Glob sources: groups of files loaded at once, on separate connections (0: one per core)
+    int loadConcurrency = 0;
+
+    // A CSV or Parquet file, by extension
+    static MiningSource file(const std::string& path, std::vector<std::string> columns = {}) {
+        MiningSource source;
+        bool parquet = path.size() >= 8 && path.compare(path.size() - 8, 8, ".parquet") == 0;
+        source.format = parquet ? SourceFormat::Parquet : SourceFormat::CSV;
+        source.path = path;
+        source.columns = std::move(columns);
+        return source;
+    }
+
+    static MiningSource csv(const std::string& path, int columnCount = 0) {
+        MiningSource source;
+        source.path = path;
+        source.csvColumnCount = columnCount;
+        return source;
+    }
+
+    static MiningSource arrow(ArrowArrayStream* stream, std::vector<std::string> columns = {}) {
+        MiningSource source;
+        source.format = SourceFormat::Arrow;
+        source.arrowStream = stream;
+        source.columns = std::move(columns);
+        return source;
+    }
+};
+
+/*
+    arrow_scan callbacks over a single ArrowArrayStream. A stream can only be read
+    once, so the first scan takes it over (binding only needs the schema).
+*/
+inline duckdb::unique_ptr<duckdb::ArrowArrayStreamWrapper> produceArrowStream(uintptr_t factory, duckdb::ArrowStreamParameters&) {
+    auto stream = reinterpret_cast<ArrowArrayStream*>(factory);
+    if (!stream->release) {
+        throw std::runtime_error("The Arrow stream has already been consumed");
+    }
+    auto wrapper = duckdb::make_uniq<duckdb::ArrowArrayStreamWrapper>();
+    wrapper->arrow_array_stream = *stream;
+    wrapper->number_of_rows = -1;
+    stream->release = nullptr;
+    return wrapper;
+}
+
+inline void arrowStreamSchema(ArrowArrayStream* stream, ArrowSchema& schema) {
+    if (!stream->release || stream->get_schema(stream, &schema) != 0) {
+        throw std::runtime_error("Could not read the Arrow stream's schema");
+    }
+}
+
+/*
+    Types whose values are equal exactly when their VARCHAR forms are, so mining
+    them natively gives the same entropies as mining everything as VARCHAR. Floats
+    aren't (0.0 = -0.0), nor is anything whose VARCHAR form depends on settings.
+*/
+inline bool preservesEquality(const std::string& type) {
+    static const std::vector<std::string> exact = {
+        "VARCHAR", "BOOLEAN", "TINYINT", "SMALLINT", "INTEGER", "BIGINT", "HUGEINT",
+        "UTINYINT", "USMALLINT", "UINTEGER", "UBIGINT", "UHUGEINT", "DATE", "TIME", "TIMESTAMP", "UUID"
+    };
+    return type.rfind("DECIMAL(", 0) == 0 || std::find(exact.begin(), exact.end(), type) != exact.end();
+}
+
+inline bool isGlob(const std::string& path) {
+    return path.find_first_of("*?[") != std::string::npos;
+}
+
+// Quote name as an SQL identifier
+inline std::string quoteIdentifier(const std::string& name) {
+    std::string quoted = "\"";
+    for (const auto& c : name) {
+        quoted += c == '"' ? "\"\"" : std::string(1, c);
+    }
+    return quoted + "\"";
+}
+
+// Quote text as an SQL string literal
+inline std::string quoteLiteral(const std::string& text) {
+    std::string quoted = "'";
+    for (const auto& c : text) {
+        quoted += c == '\'' ? "''" : std::string(1, c);
+    }
+    return quoted + "'";
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/*
+    Where the time of a query goes, in seconds. Parse is measured around parsing
+    (or preparing) the statement; bind, optimize and execute come from DuckDB's
+    profiler: bind is logical planning including binding, optimize is the
+    optimizers plus physical planning, and execute is the rest of the query.
+*/
+struct QueryTimings {
+    double parse = 0;
+    double bind = 0;
+    double optimize = 0;
+    double execute = 0;
+
+    QueryTimings& operator+=(const QueryTimings& other) {
+        parse += other.parse;
+        bind += other.bind;
+        optimize += other.optimize;
+        execute += other.execute;
+        return *this;
+    }
+
+    double total() const {
+        return parse + bind + optimize + execute;
+    }
+};
+
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+    Profile every query on conn without printing anything. Only the planner
+    phases and total latency are collected, so operators aren't timed.
+*/
+inline void enableQueryProfiling(duckdb::Connection& conn) {
+    conn.Query("PRAGMA enable_profiling = 'no_output';");
+    conn.Query("SET custom_profiling_settings = '{\"LATENCY\": \"true\", \"PLANNER\": \"true\", "
+               "\"ALL_OPTIMIZERS\": \"true\", \"PHYSICAL_PLANNER\": \"true\"}';");
+}
+
+// Bind, optimize and execute time of the last query run on conn
+inline QueryTimings lastQueryTimings(duckdb::Connection& conn) {
+    QueryTimings timings;
+    auto root = conn.GetProfilingTree();
+    if (!root) {
+        return timings;
+    }
+
+    auto& metrics = root->GetProfilingInfo().metrics;
+    auto metric = [&](duckdb::MetricsType type) {
+        auto entry = metrics.find(type);
+        return entry == metrics.end() || entry->second.IsNull() ? 0.0 : entry->second.GetValue<double>();
+    };
+    timings.bind = metric(duckdb::MetricsType::PLANNER);
+    timings.optimize = metric(duckdb::MetricsType::ALL_OPTIMIZERS) + metric(duckdb::MetricsType::PHYSICAL_PLANNER);
+    timings.execute = std::max(0.0, metric(duckdb::MetricsType::LATENCY) - timings.bind - timings.optimize);
+    return timings;
+}
+
+/*
+    Run a single statement on conn, adding its timings. Statements that don't
+    parse are handed to Query as is, so errors are reported the usual way.
+*/
+inline duckdb::unique_ptr<duckdb::MaterializedQueryResult> profiledQuery(duckdb::Connection& conn, const std::string& qry,
+                                                                         QueryTimings& timings) {
+    auto start = std::chrono::steady_clock::now();
+    duckdb::vector<duckdb::unique_ptr<duckdb::SQLStatement>> statements;
+    try {
+        statements = conn.ExtractStatements(qry);
+    } catch (std::exception&) {
+        return conn.Query(qry);
+    }
+    if (statements.size() != 1) {
+        return conn.Query(qry);
+    }
+    timings.parse += secondsSince(start);
+
+    auto result = conn.Query(std::move(statements[0]));
+    timings += lastQueryTimings(conn);
+    return result;
+}
+
+/*
+    Prepare a parameterized template on conn, adding the time to parse. The
+    statement can then be run any number of times with profiledExecute.
+*/
+inline duckdb::unique_ptr<duckdb::PreparedStatement> profiledPrepare(duckdb::Connection& conn, const std::string& qryTemplate,
+                                                                     QueryTimings& timings) {
+    auto start = std::chrono::steady_clock::now();
+    auto prepared = conn.Prepare(qryTemplate);
+    timings.parse += secondsSince(start);
+    return prepared;
+}
+
+/*
+    Execute a statement prepared on conn with values, adding its timings.
+    Binding happens on execution, once the parameter values are known.
+*/
+inline duckdb::unique_ptr<duckdb::QueryResult> profiledExecute(duckdb::Connection& conn, duckdb::PreparedStatement& prepared,
+                                                               duckdb::vector<duckdb::Value>& values, QueryTimings& timings) {
+    if (prepared.HasError()) {
+        return duckdb::make_uniq<duckdb::MaterializedQueryResult>(prepared.error);
+    }
+    auto result = prepared.Execute(values, false);
+    timings += lastQueryTimings(conn);
+    return result;
+}
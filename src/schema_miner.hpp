@@ -0,0 +1,1588 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "lattice.hpp"
+#include "entropy_store.hpp"
+#include "encoded_dataset.hpp"
+#include "connection_pool.hpp"
+#include "query_profile.hpp"
+#include "mining_budget.hpp"
+#include "mining_source.hpp"
+
+#include <iostream>
+#include <string>
+#include <set>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <functional>
+#include <cmath>
+#include <mutex>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+using AttributeSet = lattice::AttrMask;
+
+/*
+    How the survivors of layer n-1 are used to prune tuples in layer n.
+    - Filt: cross join l[n-1] and probe its nested survivor lists with filt().
+    - SemiJoin: unnest l[n-1] into s[n-1](set_id, hash) and check survival with
+      IN-subqueries, which DuckDB plans as (parallel) hash joins.
+    - Registry: sum_dict registers survivors in the extension's object cache under
+      'l[n-1]' and filt looks them up by key, so no cross join is needed. Batches
+      run one prepared template, with the sets, keys and offsets as parameters.
+    - Fused: registry survivors probed by a single hash_if_alive call per layer,
+      which hashes only rows that survive and reuses subset hashes.
+    - Native: the extension's mine_entropies() runs the whole layer loop itself,
+      so no per-layer SQL is generated.
+    - Streaming: Native straight over the source file, without materializing tbl.
+      Layer 1 is counted while the file is read, and that scan keeps every
+      column's value hashes for the later layers (while they fit in half the
+      memory budget; otherwise later layers read the file again).
+*/
+enum class PruneStrategy {
+    Filt,
+    SemiJoin,
+    Registry,
+    Fused,
+    Native,
+    Streaming
+};
+
+/*
+    Where the mined entropies go.
+    - Store: entropy store file, memory-mappable (see read_entropies).
+    - Parquet: (attribute_set, entropy, distinct_count) rows, with attribute sets
+      listing source column names.
+    - None: kept in memory only (getEntropies).
+*/
+enum class OutputSink {
+    None,
+    Store,
+    Parquet
+};
+
+/*
+    The database the miner opens, configured before anything is loaded so that
+    ingest runs under the same limits as mining.
+    - path: database file holding tbl and the layer tables ("": in memory).
+    - threads: DuckDB worker threads per query (0: all cores).
+    - memoryLimit: DuckDB's memory_limit (e.g. '8GB', "": DuckDB's default).
+    - tempDirectory: where DuckDB spills beyond the memory limit ("": DuckDB's
+      default, <path>.tmp for a database file).
+*/
+struct DatabaseOptions {
+    std::string path;
+    int threads = 0;
+    std::string memoryLimit;
+    std::string tempDirectory;
+};
+
+class SchemaMiner {
+private:
+    // Fill the config member in place and hand db its address (the config outlives db)
+    static duckdb::DBConfig* initConfig(duckdb::DBConfig& config, const DatabaseOptions& database) {
+        config.options.allow_unsigned_extensions = true;
+        if (database.threads > 0) {
+            config.SetOptionByName("threads", duckdb::Value::BIGINT(database.threads));
+        }
+        if (!database.memoryLimit.empty()) {
+            try {
+                config.SetOptionByName("memory_limit", duckdb::Value(database.memoryLimit));
+            } catch (std::exception& e) {
+                std::cerr << "\033[1;31mInvalid memory limit: \033[0m" << e.what() << "\n";
+                exit(1);
+            }
+        }
+        if (!database.tempDirectory.empty()) {
+            config.SetOptionByName("temp_directory", duckdb::Value(database.tempDirectory));
+        }
+        return &config;
+    }
+
+protected:
+    // DB (config is declared first so it is built before, and destroyed after, db)
+    duckdb::DBConfig config;
+    duckdb::DuckDB db;
+    duckdb::Connection conn;
+
+    // Relation info 
+    MiningSource source;
+    int attributeCount;
+    long tupleCount;
+    // Source names of the mined columns (attribute i is loaded into tbl as col[i])
+    std::vector<std::string> columnNames;
+    // Types of the mined columns: sniffed or read from the source, then as loaded
+    std::vector<std::string> columnTypes;
+    // Files a glob source matched, in glob order (empty: not a glob)
+    std::vector<std::string> sourceFiles;
+    // Table the layers scan: tbl, or tbl_hashed when only cell hashes are loaded
+    std::string table = "tbl";
+
+    std::string extensionPath;
+
+    // Entropies (and distinct counts) of every att. set mined so far
+    lattice::EntropyStore entropies;
+
+    // Att. sets of the last computed layer, in l[n].out.sets order
+    std::vector<AttributeSet> layerSets;
+    // Their sum_dict entropy sums (0: no survivors), fetched with the entropies
+    std::vector<double> layerSums;
+
+    // Mining options
+    PruneStrategy strategy;
+    // Debugging aid: print every layer table (with its survivor lists) as text
+    bool printLayers = false;
+    // Bytes the count tables of a layer's concurrent queries may take (0: no limit)
+    uint64_t memoryBudget = 0;
+    // Budgets checked between layers: largest att. set size (0: the whole
+    // lattice), wall-clock time from the start of mining and peak resident memory
+    int maxLayer = 0;
+    std::chrono::steady_clock::duration timeBudget = std::chrono::steady_clock::duration::zero();
+    uint64_t peakMemoryBudget = 0;
+    // Store file rewritten after every completed layer ("": none)
+    std::string checkpointPath;
+    // Keep l[n-1] (and s[n-1]) after layer n is computed, e.g. to inspect them
+    bool keepLayerTables = false;
+    // Rows of the reservoir sample (tbl_sample) layers are estimated on first (0: no sampling)
+    uint64_t sampleRows = 0;
+    bool sampleReady = false;
+    // Distinct counts of the current layer's candidates, estimated from the sample
+    std::unordered_map<AttributeSet, uint64_t> sampledDistinct;
+    // Exact distinct counts of the current layer's likely keys that verifyKeys refuted
+    std::unordered_map<AttributeSet, uint64_t> verifiedDistinct;
+
+    // Extra connections running a layer's batches concurrently (none: run on conn)
+    std::unique_ptr<ConnectionPool> pool;
+    // Registry and Fused strategies: the layer's insert templates, prepared once per
+    // connection and batch size (Fused templates don't depend on the size: 0)
+    std::map<std::pair<duckdb::Connection*, size_t>, duckdb::unique_ptr<duckdb::PreparedStatement>> layerStatements;
+    std::mutex layerStatementLock;
+
+    // Time spent in each layer's queries, indexed by layer (batches add up)
+    std::vector<QueryTimings> layerTimings;
+    std::mutex timingsLock;
+
+    // Approximate size of one sum_dict count entry (map node, hash and count)
+    static const uint64_t COUNT_ENTRY_BYTES = 64;
+
+public:
+    static constexpr const char* DEFAULT_EXTENSION_PATH = "./mining_extension/build/release/extension/quack/quack.duckdb_extension";
+    // Schema holding tbl, the layer tables and everything else the miner creates
+    static constexpr const char* MINER_SCHEMA = "schema_miner";
+
+    /*
+        Mine source. With a database path, tbl and the layer tables live in that
+        database file instead of in memory, so they can spill through DuckDB's
+        buffer manager; the miner schema a previous run left in it is dropped,
+        other schemas are left alone. A memory
+        limit also becomes the layer memory budget, since count tables live
+        outside DuckDB's buffer manager.
+    */
+    SchemaMiner(MiningSource source, PruneStrategy strategy = PruneStrategy::Filt,
+                std::string extensionPath = DEFAULT_EXTENSION_PATH, const DatabaseOptions& database = {}) : 
+        db(database.path.empty() ? nullptr : database.path.c_str(), initConfig(config, database)),
+        conn(db),
+        source(std::move(source)),
+        extensionPath(extensionPath),
+        strategy(strategy) {
+
+        resetMinerSchema();
+        if (!database.memoryLimit.empty()) {
+            memoryBudget = duckdb::DBConfig::GetConfig(*conn.context).options.maximum_memory;
+        }
+        loadExtension();
+        registerSource();
+        resolveColumns();
+
+        // Layer offsets are colex ranks, defined for up to 64 attributes
+        if (attributeCount > lattice::MAX_ATTRIBUTES) {
+            std::cerr << "\033[1;31mAt most " << lattice::MAX_ATTRIBUTES << " attributes are supported\033[0m\n";
+            exit(1);
+        }
+
+        // Streaming reads the file while mining; an Arrow stream can only be read once
+        if (strategy == PruneStrategy::Streaming && this->source.format == SourceFormat::Arrow) {
+            std::cerr << "\033[1;31mArrow streams can't be mined in streaming mode\033[0m\n";
+            exit(1);
+        }
+        if (strategy != PruneStrategy::Streaming) {
+            loadSource();
+        }
+        enableQueryProfiling(conn);
+    }
+
+    /*
+        Mine the header-less CSV at csvPath. An attributeCount of 0 sniffs the
+        number of columns from the file.
+    */
+    SchemaMiner(std::string csvPath, int attributeCount = 0, PruneStrategy strategy = PruneStrategy::Filt,
+                std::string extensionPath = DEFAULT_EXTENSION_PATH) :
+        SchemaMiner(MiningSource::csv(csvPath, attributeCount), strategy, extensionPath) {}
+
+    void setPrintLayers(bool print) {
+        printLayers = print;
+    }
+
+    void setKeepLayerTables(bool keep) {
+        keepLayerTables = keep;
+    }
+
+    /*
+        Estimate every layer's candidates on a reservoir sample of rows tuples
+        before counting them (0: don't sample). See sampleCandidates.
+    */
+    void setSampleRows(uint64_t rows) {
+        sampleRows = rows;
+    }
+
+    void setMemoryBudget(uint64_t bytes) {
+        memoryBudget = bytes;
+    }
+
+    void setMaxLayer(int layer) {
+        maxLayer = layer;
+    }
+
+    // Stop after the first layer that ends past the time budget (0: no limit)
+    void setTimeBudget(std::chrono::steady_clock::duration budget) {
+        timeBudget = budget;
+    }
+
+    // Stop after the first layer that leaves the process's peak memory above bytes (0: no limit)
+    void setPeakMemoryBudget(uint64_t bytes) {
+        peakMemoryBudget = bytes;
+    }
+
+    /*
+        Save the entropies mined so far to path after every completed layer, so
+        that a killed run keeps them.
+    */
+    void setCheckpointPath(const std::string& path) {
+        checkpointPath = path;
+    }
+
+    /*
+        Run up to concurrency batches of each layer at once, each on its own
+        connection. 1 runs everything on the main connection.
+    */
+    void setConcurrency(int concurrency) {
+        pool.reset();
+        if (concurrency > 1) {
+            pool = std::make_unique<ConnectionPool>(db, concurrency, [](duckdb::Connection& batchConn) {
+                useMinerSchema(batchConn);
+                enableQueryProfiling(batchConn);
+            });
+        }
+    }
+
+    /*
+        Start from an empty miner schema (dropping what a previous run left in a
+        database file) and create everything in it from conn.
+    */
+    void resetMinerSchema() {
+        conn.Query("DROP SCHEMA IF EXISTS " + std::string(MINER_SCHEMA) + " CASCADE;");
+        auto result = conn.Query("CREATE SCHEMA " + std::string(MINER_SCHEMA) + ";");
+        if (result->HasError()) {
+            std::cerr << "\033[1;31mFailed to create the miner schema: \033[0m" << result->GetError() << "\n";
+            exit(1);
+        }
+        useMinerSchema(conn);
+    }
+
+    // Resolve (and create) unqualified tables in the miner schema on minerConn
+    static void useMinerSchema(duckdb::Connection& minerConn) {
+        minerConn.Query("SET schema = '" + std::string(MINER_SCHEMA) + "';");
+    }
+
+    void loadExtension() {
+        std::string loadQry = "LOAD '" + extensionPath + "';";
+
+        auto loadResult = conn.Query(loadQry);
+
+        if (loadResult->HasError()) {
+            std::string loadErrMsg = "\033[1;31mFailed to load mining extension: \033[0m";
+            std::cerr << loadErrMsg << loadResult->ToString();
+            exit(1);
+        }
+    }
+
+    /*
+        Make an Arrow source scannable as the arrow_source view.
+    */
+    void registerSource() {
+        if (source.format != SourceFormat::Arrow) {
+            return;
+        }
+        conn.TableFunction("arrow_scan", {
+            duckdb::Value::POINTER((uintptr_t) source.arrowStream),
+            duckdb::Value::POINTER((uintptr_t) &produceArrowStream),
+            duckdb::Value::POINTER((uintptr_t) &arrowStreamSchema)
+        })->CreateView("arrow_source", true, true);
+    }
+
+    /*
+        Table function call (or view) reading the source, or only the given files
+        of a glob source. CSV columns are read as col0..col[n-1].
+    */
+    std::string sourceScan(const std::vector<std::string>& files = {}) {
+        std::string paths = quoteLiteral(source.path);
+        if (!files.empty()) {
+            paths = "[";
+            for (const auto& file : files) {
+                paths += quoteLiteral(file) + ", ";
+            }
+            paths.resize(paths.size() - 2); // Remove last comma
+            paths += "]";
+        }
+        switch (source.format) {
+            case SourceFormat::CSV: {
+                std::string scan = "read_csv(" + paths + ", header=false, columns={";
+                for (int i = 0; i < source.csvColumnCount; i++) {
+                    scan += "'col" + std::to_string(i) + "': 'VARCHAR'";
+                    if (i != source.csvColumnCount - 1) {
+                        scan += ",";
+                    }
+                }
+                return scan + "})";
+            }
+            case SourceFormat::Parquet:
+                return "read_parquet(" + paths + ")";
+            case SourceFormat::Arrow:
+                return "arrow_source";
+        }
+        return "";
+    }
+
+    /*
+        Resolve the names and types of the mined columns (by default all of them).
+        CSV columns and their types are sniffed (the column count only unless
+        given); other sources are only bound, so an Arrow stream isn't consumed.
+    */
+    void resolveColumns() {
+        std::string scan = source.format == SourceFormat::CSV ?
+                           "read_csv(" + quoteLiteral(source.path) + ", header=false)" : sourceScan();
+        auto result = conn.Query("DESCRIBE SELECT * FROM " + scan + ";");
+        if (result->HasError()) {
+            std::cerr << "\033[1;31mFailed to read the source: \033[0m" << result->GetError() << "\n";
+            exit(1);
+        }
+
+        std::vector<std::string> available;
+        std::vector<std::string> availableTypes;
+        for (idx_t row = 0; row < result->RowCount(); row++) {
+            available.push_back(result->GetValue(0, row).ToString());
+            availableTypes.push_back(result->GetValue(1, row).ToString());
+        }
+        if (source.format == SourceFormat::CSV) {
+            if (source.csvColumnCount == 0) {
+                source.csvColumnCount = available.size();
+            }
+            availableTypes.resize(source.csvColumnCount, "VARCHAR");
+            available.clear();
+            for (int i = 0; i < source.csvColumnCount; i++) {
+                available.push_back("col" + std::to_string(i));
+            }
+        }
+
+        columnNames = source.columns.empty() ? available : source.columns;
+        columnTypes.clear();
+        for (const auto& name : columnNames) {
+            auto column = std::find(available.begin(), available.end(), name);
+            if (column == available.end()) {
+                std::cerr << "\033[1;31mUnknown column '" << name << "'\033[0m\n";
+                exit(1);
+            }
+            columnTypes.push_back(availableTypes[column - available.begin()]);
+        }
+        attributeCount = columnNames.size();
+
+        if (source.format != SourceFormat::Arrow && isGlob(source.path)) {
+            auto files = conn.Query("SELECT file FROM glob(" + quoteLiteral(source.path) + ");");
+            for (idx_t row = 0; !files->HasError() && row < files->RowCount(); row++) {
+                sourceFiles.push_back(files->GetValue(0, row).ToString());
+            }
+        }
+    }
+
+    const std::vector<std::string>& getColumnTypes() {
+        return columnTypes;
+    }
+
+    const std::vector<std::string>& getColumnNames() {
+        return columnNames;
+    }
+
+    /*
+        Load the mined columns into tbl as col0..col[n-1]. Only those columns are
+        read, which Parquet and Arrow scans push down. Columns keep their type if
+        it compares like VARCHAR (so entropies match an all-VARCHAR load) and are
+        cast to VARCHAR otherwise. CSV columns are read as VARCHAR and cast to
+        their sniffed types while loading, where narrowColumnTypes found that
+        every value round trips.
+
+        With hashCells, tbl_hashed gets hash(value) of every cell instead, during
+        the same scan. The layer kernels hash those UBIGINTs once more, which is a
+        bijection on 64 bits, so no further collisions are added.
+
+        With a cache, tbl_hashed is a view over the cached hashes if the cache is
+        current, and the cache is written from tbl_hashed otherwise.
+    */
+    void loadSource() {
+        bool cached = !source.cachePath.empty() && source.format != SourceFormat::Arrow && !isGlob(source.path);
+        source.hashCells = source.hashCells || cached;
+        table = source.hashCells ? "tbl_hashed" : "tbl";
+        if (source.format == SourceFormat::CSV && !source.hashCells) {
+            narrowColumnTypes();
+        }
+
+        std::string projection;
+        for (int i = 0; i < attributeCount; i++) {
+            std::string column = quoteIdentifier(columnNames[i]);
+            bool keepType = source.preserveTypes && preservesEquality(columnTypes[i]);
+            if (source.format == SourceFormat::CSV) {
+                bool narrow = !source.hashCells && columnTypes[i] != "VARCHAR";
+                column = narrow ? "TRY_CAST(" + column + " AS " + columnTypes[i] + ")" : "CAST(" + column + " AS VARCHAR)";
+            } else if (!keepType) {
+                column = "CAST(" + column + " AS VARCHAR)";
+                columnTypes[i] = "VARCHAR";
+            }
+            if (source.hashCells) {
+                column = "hash(" + column + ")";
+                columnTypes[i] = "UBIGINT";
+            }
+            projection += column + " AS col" + std::to_string(i);
+            if (i != attributeCount - 1) {
+                projection += ", ";
+            }
+        }
+
+        // The projection spells out the columns and how they are read
+        lattice::DatasetKey key;
+        if (cached) {
+            try {
+                key = lattice::datasetKey(source.path, sourceScan() + " " + projection);
+            } catch (std::runtime_error& e) {
+                cached = false;
+            }
+        }
+        if (cached && loadCachedSource(key)) {
+            return;
+        }
+
+        if (sourceFiles.size() > 1) {
+            loadFiles(projection);
+        } else {
+            conn.Query("CREATE TABLE " + table + " AS SELECT " + projection + " FROM " + sourceScan() + ";");
+        }
+
+        tupleCount = conn.Query("SELECT count(*) FROM " + table + ";")->GetValue(0, 0).GetValue<int64_t>();
+        entropies.setTupleCount(tupleCount);
+        if (cached) {
+            writeSourceCache(key);
+        }
+    }
+
+    /*
+        Load the files of a glob source in parallel: they are split into groups of
+        about equal size, and each group is parsed and appended to the table by
+        its own INSERT on its own connection, so parsing (and reading) spreads
+        over every core and disk instead of queueing behind one scan. Layer
+        queries over the table then aggregate its row groups in parallel, with
+        sum_dict merging the per-thread partial counts.
+    */
+    void loadFiles(const std::string& projection) {
+        conn.Query("CREATE TABLE " + table + " AS SELECT " + projection + " FROM " + sourceScan({sourceFiles[0]}) + " LIMIT 0;");
+
+        int groupCount = source.loadConcurrency > 0 ? source.loadConcurrency : std::max(1u, std::thread::hardware_concurrency());
+        groupCount = std::min<int>(groupCount, sourceFiles.size());
+
+        // Largest files first, each into the group with the fewest bytes so far
+        std::vector<std::pair<uintmax_t, std::string>> files;
+        for (const auto& file : sourceFiles) {
+            std::error_code error;
+            auto size = std::filesystem::file_size(file, error);
+            files.emplace_back(error ? 0 : size, file);
+        }
+        std::sort(files.begin(), files.end(), std::greater<std::pair<uintmax_t, std::string>>());
+        std::vector<std::vector<std::string>> groups(groupCount);
+        std::vector<uintmax_t> groupBytes(groupCount, 0);
+        for (const auto& [size, file] : files) {
+            auto group = std::min_element(groupBytes.begin(), groupBytes.end()) - groupBytes.begin();
+            groups[group].push_back(file);
+            groupBytes[group] += size;
+        }
+
+        ConnectionPool loaders(db, groupCount, useMinerSchema);
+        for (const auto& group : groups) {
+            std::string qry = "INSERT INTO " + table + " SELECT " + projection + " FROM " + sourceScan(group) + ";";
+            loaders.submit([qry](duckdb::Connection& loadConn) {
+                auto result = loadConn.Query(qry);
+                if (result->HasError()) {
+                    throw std::runtime_error(result->GetError());
+                }
+            });
+        }
+        try {
+            loaders.wait();
+        } catch (std::runtime_error& e) {
+            std::cerr << "\033[1;31mFailed to read the source: \033[0m" << e.what() << "\n";
+            exit(1);
+        }
+    }
+
+    // Scan the cached hashes as tbl_hashed if the cache was encoded with key
+    bool loadCachedSource(const lattice::DatasetKey& key) {
+        uint64_t rows;
+        try {
+            lattice::MappedEncodedDataset dataset(source.cachePath);
+            if (!(dataset.key() == key) || dataset.columnCount() != (uint64_t) attributeCount) {
+                return false;
+            }
+            rows = dataset.rowCount();
+        } catch (std::runtime_error& e) {
+            return false;
+        }
+
+        auto result = conn.Query("CREATE VIEW tbl_hashed AS SELECT * FROM read_encoded(" + quoteLiteral(source.cachePath) + ");");
+        if (result->HasError()) {
+            return false;
+        }
+        tupleCount = rows;
+        entropies.setTupleCount(tupleCount);
+        return true;
+    }
+
+    // Write tbl_hashed to the cache, one column at a time. Mining goes on if it fails.
+    void writeSourceCache(const lattice::DatasetKey& key) {
+        try {
+            lattice::EncodedDatasetWriter writer(source.cachePath, key, tupleCount, attributeCount);
+            for (int i = 0; i < attributeCount; i++) {
+                auto result = conn.SendQuery("SELECT col" + std::to_string(i) + " FROM tbl_hashed;");
+                while (auto chunk = result->Fetch()) {
+                    if (chunk->size() == 0) {
+                        break;
+                    }
+                    chunk->data[0].Flatten(chunk->size());
+                    writer.append(duckdb::FlatVector::GetData<uint64_t>(chunk->data[0]), chunk->size());
+                }
+                if (result->HasError()) {
+                    throw std::runtime_error(result->GetError());
+                }
+            }
+            writer.finish();
+        } catch (std::exception& e) {
+            std::cerr << "\033[1;31mFailed to write the dataset cache: \033[0m" << e.what() << "\n";
+        }
+    }
+
+    /*
+        Keep the sniffed type of a CSV column only if every value survives the
+        round trip through it, e.g. a column holding '007' stays VARCHAR since 007
+        and 7 would become equal as INTEGERs. All columns are checked in one scan
+        of the source, before it is loaded.
+    */
+    void narrowColumnTypes() {
+        std::vector<int> narrowed;
+        std::string checks;
+        for (int i = 0; i < attributeCount; i++) {
+            if (source.preserveTypes && columnTypes[i] != "VARCHAR" && preservesEquality(columnTypes[i])) {
+                std::string col = quoteIdentifier(columnNames[i]);
+                checks += "bool_and(TRY_CAST(" + col + " AS " + columnTypes[i] + ")::VARCHAR IS NOT DISTINCT FROM " + col + "), ";
+                narrowed.push_back(i);
+            } else {
+                columnTypes[i] = "VARCHAR";
+            }
+        }
+        if (narrowed.empty()) {
+            return;
+        }
+        checks.resize(checks.size() - 2); // Remove last comma
+
+        auto result = conn.Query("SELECT " + checks + " FROM " + sourceScan() + ";");
+        for (size_t c = 0; c < narrowed.size(); c++) {
+            int i = narrowed[c];
+            auto roundTrips = result->HasError() ? duckdb::Value::BOOLEAN(false) : result->GetValue(c, 0);
+            // (an empty source has nothing to contradict the type)
+            if (!roundTrips.IsNull() && !roundTrips.GetValue<bool>()) {
+                columnTypes[i] = "VARCHAR";
+            }
+        }
+    }
+
+    const lattice::EntropyStore& getEntropies() {
+        return entropies;
+    }
+
+    const std::vector<QueryTimings>& getLayerTimings() {
+        return layerTimings;
+    }
+
+    void printLayerTimings() {
+        std::cout << "layer\tparse (ms)\tbind (ms)\toptimize (ms)\texecute (ms)\n";
+        std::cout << std::fixed << std::setprecision(1);
+        for (size_t n = 1; n < layerTimings.size(); n++) {
+            const auto& timings = layerTimings[n];
+            std::cout << n << "\t" << timings.parse * 1000 << "\t" << timings.bind * 1000 << "\t"
+                      << timings.optimize * 1000 << "\t" << timings.execute * 1000 << "\n";
+        }
+        std::cout << std::defaultfloat;
+    }
+
+    void addLayerTimings(int n, const QueryTimings& timings) {
+        std::lock_guard<std::mutex> guard(timingsLock);
+        if ((int) layerTimings.size() <= n) {
+            layerTimings.resize(n + 1);
+        }
+        layerTimings[n] += timings;
+    }
+
+    /*
+        Run one of layer n's queries on queryConn, accounting its time to the layer.
+    */
+    duckdb::unique_ptr<duckdb::MaterializedQueryResult> layerQuery(duckdb::Connection& queryConn, int n, const std::string& qry) {
+        QueryTimings timings;
+        auto result = profiledQuery(queryConn, qry, timings);
+        addLayerTimings(n, timings);
+        return result;
+    }
+
+    /*
+        Throw the error of a failed layer query. A layer with a failed query is
+        incomplete, so mining stops there (see computeEntropiesWithPruning); on a
+        pool connection the error reaches the caller through ConnectionPool::wait.
+    */
+    template <class RESULT>
+    static void checkLayerResult(const RESULT& result) {
+        if (result->HasError()) {
+            throw std::runtime_error(result->GetError());
+        }
+    }
+
+    /*
+        Write the entropy store to path (memory-mappable, see read_entropies in
+        the extension).
+    */
+    void saveEntropies(const std::string& path) {
+        try {
+            entropies.save(path);
+        } catch (std::runtime_error& e) {
+            std::cerr << "\033[1;31mFailed to save entropies: \033[0m" << e.what() << "\n";
+        }
+    }
+
+    /*
+        Write the entropies mined so far to a Parquet file of (attribute_set,
+        entropy, distinct_count) rows, smallest sets first.
+    */
+    void exportParquet(const std::string& path) {
+        conn.Query("CREATE OR REPLACE TABLE mined_entropies(attribute_set VARCHAR[], entropy DOUBLE, distinct_count UBIGINT);");
+        try {
+            duckdb::Appender appender(conn, "mined_entropies");
+            entropies.forEach([&](const lattice::EntropyRecord& record) {
+                duckdb::vector<duckdb::Value> names;
+                lattice::forEachAtt(record.mask, [&](int att) {
+                    names.push_back(duckdb::Value(columnNames[att]));
+                });
+                appender.BeginRow();
+                appender.Append(duckdb::Value::LIST(duckdb::LogicalType::VARCHAR, names));
+                appender.Append<double>(record.entropy);
+                appender.Append<uint64_t>(record.distinctCount);
+                appender.EndRow();
+            });
+            appender.Close();
+        } catch (std::exception& e) {
+            std::cerr << "\033[1;31mFailed to export entropies: \033[0m" << e.what() << "\n";
+            return;
+        }
+
+        auto result = conn.Query("COPY (SELECT * FROM mined_entropies ORDER BY len(attribute_set), attribute_set) TO " +
+                                 quoteLiteral(path) + " (FORMAT PARQUET);");
+        if (result->HasError()) {
+            std::cerr << "\033[1;31mFailed to export entropies: \033[0m" << result->GetError() << "\n";
+        }
+        conn.Query("DROP TABLE mined_entropies;");
+    }
+
+    // Write the entropies mined so far to sink
+    void writeOutput(OutputSink sink, const std::string& path) {
+        switch (sink) {
+            case OutputSink::Store:
+                saveEntropies(path);
+                break;
+            case OutputSink::Parquet:
+                exportParquet(path);
+                break;
+            case OutputSink::None:
+                break;
+        }
+    }
+
+    /*
+        This method prunes entire attribute sets where possible but doesn't 
+        prune individual tuples.
+    */
+    void computeEntropiesPruneSets() {
+        std::string computeQry = "SELECT prune(custom_sum(lift_exact([";
+        for (int i = 0; i < attributeCount; i++) {
+            computeQry += "col" + std::to_string(i);
+            if (i != attributeCount - 1) {
+                computeQry += ", ";
+            }
+        }
+        computeQry += "]))) FROM " + table + ";";
+        bool hasResults = true;
+
+        while (hasResults) {
+            auto entropiesResult = conn.Query(computeQry);
+            auto map = entropiesResult->GetValue(0, 0);
+            auto entryCount = duckdb::MapValue::GetChildren(map).size();
+
+            hasResults = entryCount > 0;
+        }
+    }
+
+    /*
+        Generate all n-set combinations of attributes.
+    */
+    std::vector<AttributeSet> getAttributeCombinations(int n) {
+        std::vector<AttributeSet> combinations;
+
+        std::function<void(AttributeSet, int, int)> generateCombinations = [&](AttributeSet atts, int start, int k) {
+            if (k == 0) {
+                combinations.push_back(atts);
+                return;
+            }
+
+            for (int i = start; i <= attributeCount - k; i++) {
+                generateCombinations(lattice::withAtt(atts, i), i + 1, k - 1);
+            }
+        };
+
+        generateCombinations(0, 0, n);
+        return combinations;
+    }
+
+    /*
+        The (n-1)-subsets of an n-set, dropping atts. from the back so that the
+        prefix (the set without its last att.) comes first.
+    */
+    std::vector<AttributeSet> getSubsets(AttributeSet attSet) {
+        std::vector<AttributeSet> subsets;
+        auto atts = lattice::toAtts(attSet);
+        for (int i = atts.size() - 1; i >= 0; i--) {
+            subsets.push_back(lattice::withoutAtt(attSet, atts[i]));
+        }
+        return subsets;
+    }
+
+    /*
+        Compute entropies for all 1-sets in a single query and make resulting table
+    */
+    void computeFirstLayer() {
+        std::string qry = "CREATE TABLE l1 AS SELECT sum_dict([\n";
+        for (int i = 0; i < attributeCount; i++) {
+            qry += "\thash_row(col" + std::to_string(i) + "),\n";
+        }
+        qry.resize(qry.size() - 2); // Remove last comma and newline
+        qry += "]" + survivorKeyArg("l1") + ") AS out\nFROM " + table + ";";
+
+        checkLayerResult(layerQuery(conn, 1, qry));
+        layerSets = getAttributeCombinations(1);
+        storeLayerEntropies(1);
+        if (printLayers) {
+            conn.Query("SELECT * FROM l1;")->Print();
+        }
+    }
+
+    /*
+        Extra sum_dict argument registering the survivors of layer n in the
+        object cache (Registry and Fused strategies only).
+    */
+    bool usesRegistry() {
+        return strategy == PruneStrategy::Registry || strategy == PruneStrategy::Fused;
+    }
+
+    /*
+        Batches insert their row into l[n] through a prepared layer template
+        (Registry and Fused strategies) instead of creating a table each.
+    */
+    bool usesLayerTemplate() {
+        return strategy == PruneStrategy::Registry || strategy == PruneStrategy::Fused;
+    }
+
+    std::string survivorKeyArg(const std::string& key) {
+        if (!usesRegistry()) {
+            return "";
+        }
+        return ", '" + key + "'";
+    }
+
+    /*
+        Unnest the survivors of layer n into s[n](set_id, hash), one row per
+        non-unique value of each attribute set. Accounted to layer n + 1, which
+        probes them.
+    */
+    void unnestSurvivors(int n) {
+        std::string layer = std::to_string(n);
+        checkLayerResult(layerQuery(conn, n + 1,
+            "CREATE OR REPLACE TABLE s" + layer + " AS\n"
+            "SELECT set_id, UNNEST(hashes) AS hash\n"
+            "FROM (SELECT UNNEST(range(len(out.sets))) AS set_id, UNNEST(out.sets) AS hashes FROM l" + layer + ");"
+        ));
+    }
+
+    // Hash of the set's values; columns keep their types, so no common list type is needed
+    std::string hashRowExpr(AttributeSet atts) {
+        std::string expr = "hash_row(";
+        lattice::forEachAtt(atts, [&](int att) {
+            expr += "col" + std::to_string(att) + ", ";
+        });
+        expr.resize(expr.size() - 2); // Remove last comma
+        return expr + ")";
+    }
+
+    // Att. sets as an INTEGER[][] value, bound to a template parameter
+    duckdb::Value attSetsValue(const std::vector<AttributeSet>& attSets) {
+        duckdb::vector<duckdb::Value> sets;
+        for (const auto& atts : attSets) {
+            duckdb::vector<duckdb::Value> attValues;
+            lattice::forEachAtt(atts, [&](int att) {
+                attValues.push_back(duckdb::Value::INTEGER(att));
+            });
+            sets.push_back(duckdb::Value::LIST(duckdb::LogicalType::INTEGER, std::move(attValues)));
+        }
+        return duckdb::Value::LIST(duckdb::LogicalType::LIST(duckdb::LogicalType::INTEGER), std::move(sets));
+    }
+
+    /*
+        Build the layer n query with survivor checks expressed as IN-subqueries
+        over s[n-1]. Each (n-1)-set is checked once per tuple and the resulting
+        flags are shared by every candidate containing it.
+    */
+    std::string buildSemiJoinLayerQuery(int n, const std::string& target, const std::vector<AttributeSet>& attSets,
+                                        const std::vector<AttributeSet>& prevAttSets,
+                                        const lattice::LayerIndex& prevIndex) {
+        std::string prevSurvivors = "s" + std::to_string(n - 1);
+
+        // Only check the (n-1)-sets some candidate is built from
+        std::set<int> referenced;
+        for (auto& atts : attSets) {
+            for (const auto& subset : getSubsets(atts)) {
+                referenced.insert(prevIndex.find(subset));
+            }
+        }
+
+        std::string qry = "CREATE TABLE " + target + " AS\nWITH alive AS (\n\tSELECT *,\n";
+        for (const auto& i : referenced) {
+            qry += "\t\t" + hashRowExpr(prevAttSets[i]) + " IN (SELECT hash FROM " + prevSurvivors +
+                   " WHERE set_id = " + std::to_string(i) + ") AS a" + std::to_string(i) + ",\n";
+        }
+        qry.resize(qry.size() - 2); // Remove last comma and newline
+        qry += "\n\tFROM " + table + "\n)\nSELECT sum_dict([\n";
+
+        for (auto& atts : attSets) {
+            qry += "\tCASE WHEN ";
+            for (const auto& subset : getSubsets(atts)) {
+                qry += "a" + std::to_string(prevIndex.find(subset)) + " AND ";
+            }
+            qry.resize(qry.size() - 5); // Remove last AND
+            qry += " THEN " + hashRowExpr(atts) + " ELSE NULL END,\n";
+        }
+        qry.resize(qry.size() - 2); // Remove last comma and newline
+
+        qry += "]) AS out\nFROM alive;";
+        return qry;
+    }
+
+    /*
+        Build the layer template for a single hash_if_alive call, inserting one
+        row per batch into l[n] (created by runLayerQuery). The survivor keys ($1
+        for l[n-1], $4 for the batch), the layouts of l[n-1] ($2) and the batch
+        ($3) and the batch number ($5) are parameters, so the text is the same for
+        every batch of the layer: each connection prepares it once and the
+        candidate lists are never printed or parsed.
+    */
+    std::string buildFusedLayerTemplate(int n) {
+        std::string qry = "INSERT INTO l" + std::to_string(n) + " SELECT $5::INTEGER AS batch, "
+                          "sum_dict(hash_if_alive($1, $2::INTEGER[][], $3::INTEGER[][]";
+        for (int i = 0; i < attributeCount; i++) {
+            qry += ", col" + std::to_string(i);
+        }
+        qry += "), $4) AS out\nFROM " + table + ";";
+        return qry;
+    }
+
+    /*
+        Build the Registry layer template for batches of setCount n-sets, inserting
+        one row per batch into l[n] like the fused template. Each candidate probes
+        filt per (n-1)-subset, and every hashed set is a hash_atts layout parameter,
+        so the text only depends on the batch size: the survivor keys ($1 for
+        l[n-1], $2 for the batch) and batch number ($3) come first, then per
+        candidate its atts. and each subset's atts. and offset in l[n-1].
+    */
+    std::string buildRegistryLayerTemplate(int n, size_t setCount) {
+        std::string cols;
+        for (int i = 0; i < attributeCount; i++) {
+            cols += ", col" + std::to_string(i);
+        }
+
+        std::string qry = "INSERT INTO l" + std::to_string(n) + " SELECT $3::INTEGER AS batch, sum_dict([\n";
+        int param = 4;
+        for (size_t i = 0; i < setCount; i++) {
+            std::string setParam = std::to_string(param++);
+            qry += "\tCASE\n\t\tWHEN ";
+            for (int j = 0; j < n; j++) {
+                std::string attsParam = std::to_string(param++);
+                std::string offsetParam = std::to_string(param++);
+                qry += "filt(hash_atts($" + attsParam + "::INTEGER[]" + cols + "), $1::VARCHAR, $" + offsetParam + "::INTEGER) AND\n\t\t\t";
+            }
+            qry.resize(qry.size() - 7); // Remove last AND\n\t\t\t
+            qry += "\n\t\tTHEN hash_atts($" + setParam + "::INTEGER[]" + cols + ")\n\t\tELSE NULL\n\tEND,\n";
+        }
+        qry.resize(qry.size() - 2); // Remove last comma and newline
+
+        qry += "], $2) AS out\nFROM " + table + ";";
+        return qry;
+    }
+
+    // Att. set as an INTEGER[] value, bound to a hash_atts parameter
+    duckdb::Value attsValue(AttributeSet atts) {
+        duckdb::vector<duckdb::Value> attValues;
+        lattice::forEachAtt(atts, [&](int att) {
+            attValues.push_back(duckdb::Value::INTEGER(att));
+        });
+        return duckdb::Value::LIST(duckdb::LogicalType::INTEGER, std::move(attValues));
+    }
+
+    /*
+        The layer n template for batches of setCount sets, prepared on batchConn
+        the first time it is asked for.
+    */
+    duckdb::PreparedStatement& layerStatement(duckdb::Connection& batchConn, int n, size_t setCount, QueryTimings& timings) {
+        auto key = std::make_pair(&batchConn, strategy == PruneStrategy::Fused ? 0 : setCount);
+        {
+            std::lock_guard<std::mutex> guard(layerStatementLock);
+            auto entry = layerStatements.find(key);
+            if (entry != layerStatements.end()) {
+                return *entry->second;
+            }
+        }
+        // Only this connection's thread prepares its statements
+        auto qry = strategy == PruneStrategy::Fused ? buildFusedLayerTemplate(n) : buildRegistryLayerTemplate(n, setCount);
+        auto prepared = profiledPrepare(batchConn, qry, timings);
+        std::lock_guard<std::mutex> guard(layerStatementLock);
+        return *(layerStatements[key] = std::move(prepared));
+    }
+
+    /*
+        Compute entropies for all n-sets in a single query.
+        Assume that the previous layer query has been executed and stored in the table l[n-1]
+        and original relation is stored in tbl.
+
+        Only Apriori candidates are computed: n-sets whose every (n-1)-subset
+        still has survivors (non-zero entropy sum) in l[n-1].
+
+        Returns 1 if at least one valid n-set is found, 0 otherwise. 
+    */
+    int computeSingleLayer(int n) {
+        auto prevAttSets = layerSets;
+
+        std::vector<AttributeSet> survivingSets;
+        for (size_t i = 0; i < prevAttSets.size(); i++) {
+            if (layerSums[i] != 0) {
+                survivingSets.push_back(prevAttSets[i]);
+            }
+        }
+        // (a sampled layer may be ordered by size rather than lexicographically)
+        std::sort(survivingSets.begin(), survivingSets.end(), lattice::lexLess);
+        auto attSets = lattice::aprioriCandidates(survivingSets);
+        if (sampleRows > 0 && !attSets.empty()) {
+            attSets = sampleCandidates(n, attSets);
+        }
+        if (attSets.empty()) {
+            return 0;
+        }
+        layerSets = attSets;
+
+        runLayerQuery(n, attSets, prevAttSets);
+        storeLayerEntropies(n);
+        if (printLayers) {
+            conn.Query("SELECT * FROM l" + std::to_string(n) + ";")->Print();
+        }
+        return hasNonZeroEntropy();
+    }
+
+    /*
+        Reservoir sample of the mined table, taken once. Returns false when the
+        table is no larger than the sample, where estimating wouldn't save a scan.
+    */
+    bool prepareSample() {
+        if (!sampleReady && sampleRows < (uint64_t) tupleCount) {
+            auto result = conn.Query("CREATE OR REPLACE TABLE tbl_sample AS SELECT * FROM " + table +
+                                     " USING SAMPLE reservoir(" + std::to_string(sampleRows) + " ROWS) REPEATABLE (42);");
+            sampleReady = !result->HasError();
+        }
+        return sampleReady;
+    }
+
+    /*
+        Sampled pre-pass over layer n's candidates. Each candidate's distinct count
+        is estimated from its sample distinct count d and singletons f1 with the
+        GEE estimator, sqrt(N/n) * f1 + (d - f1), which is within a factor of
+        sqrt(N/n) of the true count. Candidates are ordered by their estimates,
+        largest first, so the biggest batches start first when they run
+        concurrently. Batches are still sized by estimateCountSizes' bounds, since
+        an estimate can fall short of the true count.
+
+        Candidates that are keys of the sample are likely keys of the table. They
+        only need verifying (count(DISTINCT) with DuckDB's own, spillable hash
+        aggregate) instead of a full count table with survivor lists: confirmed
+        keys are stored with entropy log2(N) and left out of the layer, the rest
+        are counted as usual. Returns the candidates left to count.
+    */
+    std::vector<AttributeSet> sampleCandidates(int n, const std::vector<AttributeSet>& attSets) {
+        if (!prepareSample()) {
+            return attSets;
+        }
+
+        std::string hashes;
+        for (const auto& atts : attSets) {
+            hashes += hashRowExpr(atts) + ", ";
+        }
+        hashes.resize(hashes.size() - 2); // Remove last comma
+        auto result = layerQuery(conn, n,
+            "SELECT set_id, count(*) AS d, count(*) FILTER (WHERE c = 1) AS f1, sum(c) AS rows\n"
+            "FROM (\n"
+            "\tSELECT set_id, h, count(*) AS c\n"
+            "\tFROM (SELECT UNNEST(range(" + std::to_string(attSets.size()) + ")) AS set_id, UNNEST([" + hashes + "]) AS h FROM tbl_sample)\n"
+            "\tGROUP BY set_id, h\n"
+            ")\nGROUP BY set_id;"
+        );
+        if (result->HasError()) {
+            return attSets;
+        }
+
+        sampledDistinct.clear();
+        verifiedDistinct.clear();
+        std::vector<AttributeSet> likelyKeys;
+        for (idx_t row = 0; row < result->RowCount(); row++) {
+            auto atts = attSets[result->GetValue(0, row).GetValue<int64_t>()];
+            auto distinct = result->GetValue(1, row).GetValue<int64_t>();
+            auto singletons = result->GetValue(2, row).GetValue<int64_t>();
+            auto sampled = result->GetValue(3, row).GetValue<double>();
+            if (singletons == sampled) {
+                likelyKeys.push_back(atts);
+                continue;
+            }
+            double estimate = std::sqrt(tupleCount / sampled) * singletons + (distinct - singletons);
+            sampledDistinct[atts] = std::min<uint64_t>(tupleCount, std::max<double>(estimate, distinct));
+        }
+        auto keys = verifyKeys(n, likelyKeys);
+
+        std::vector<AttributeSet> remaining;
+        for (const auto& atts : attSets) {
+            if (!keys.count(atts)) {
+                remaining.push_back(atts);
+            }
+        }
+        auto sizes = estimateCountSizes(remaining);
+        for (size_t i = 0; i < remaining.size(); i++) {
+            auto sampled = sampledDistinct.find(remaining[i]);
+            if (sampled != sampledDistinct.end()) {
+                sizes[i] = std::min(sizes[i], sampled->second * COUNT_ENTRY_BYTES);
+            }
+        }
+        std::vector<size_t> order(remaining.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+        std::vector<AttributeSet> ordered;
+        for (auto i : order) {
+            ordered.push_back(remaining[i]);
+        }
+        return ordered;
+    }
+
+    /*
+        Check which of the likely keys are keys of the table, with a single scan,
+        and store their entropies. Returns the confirmed keys.
+    */
+    std::set<AttributeSet> verifyKeys(int n, const std::vector<AttributeSet>& likelyKeys) {
+        std::set<AttributeSet> keys;
+        if (likelyKeys.empty()) {
+            return keys;
+        }
+
+        std::string counts;
+        for (const auto& atts : likelyKeys) {
+            counts += "count(DISTINCT " + hashRowExpr(atts) + "), ";
+        }
+        counts.resize(counts.size() - 2); // Remove last comma
+        auto result = layerQuery(conn, n, "SELECT " + counts + " FROM " + table + ";");
+        if (result->HasError()) {
+            return keys;
+        }
+
+        for (size_t i = 0; i < likelyKeys.size(); i++) {
+            auto distinct = result->GetValue(i, 0).GetValue<int64_t>();
+            if (distinct == tupleCount) {
+                keys.insert(likelyKeys[i]);
+                entropies.put(likelyKeys[i], std::log2((double) tupleCount), tupleCount);
+            } else {
+                verifiedDistinct[likelyKeys[i]] = distinct;
+            }
+        }
+        return keys;
+    }
+
+    /*
+        Upper bound on the bytes each candidate's sum_dict count table takes: a set
+        has at most min(N, distinct(A - a) * distinct(a)) values for any a in it,
+        or its exact distinct count where verifyKeys counted it. Sample estimates
+        can undershoot, so they aren't used here.
+    */
+    std::vector<uint64_t> estimateCountSizes(const std::vector<AttributeSet>& attSets) {
+        std::vector<uint64_t> sizes;
+        for (const auto& atts : attSets) {
+            uint64_t values = tupleCount;
+            lattice::forEachAtt(atts, [&](int att) {
+                auto subset = entropies.find(lattice::withoutAtt(atts, att));
+                auto single = entropies.find(lattice::attBit(att));
+                // (checked by division so the product can't overflow)
+                if (subset && single && subset->distinctCount <= values / std::max<uint64_t>(single->distinctCount, 1)) {
+                    values = subset->distinctCount * single->distinctCount;
+                }
+            });
+            auto verified = verifiedDistinct.find(atts);
+            if (verified != verifiedDistinct.end()) {
+                values = std::min(values, verified->second);
+            }
+            sizes.push_back(values * COUNT_ENTRY_BYTES);
+        }
+        return sizes;
+    }
+
+    /*
+        Create l[n] from the candidate n-sets with the configured strategy. When the
+        count tables would exceed the memory budget, or the pool can run several
+        queries at once, the candidates are split into batches, each computed by its
+        own query (one more pass over tbl each) into l[n]_[b], and the batches are
+        concatenated into l[n]. Batches run concurrently on the pool's connections,
+        each within its share of the budget. With the Fused strategy every batch
+        inserts its row into l[n] through the same prepared template instead.
+    */
+    void runLayerQuery(int n, const std::vector<AttributeSet>& attSets, const std::vector<AttributeSet>& prevAttSets) {
+        std::string layer = "l" + std::to_string(n);
+        int concurrency = pool ? pool->size() : 1;
+        auto bounds = lattice::batchBounds(estimateCountSizes(attSets), memoryBudget / concurrency, concurrency);
+        int batchCount = bounds.size() - 1;
+
+        if (strategy == PruneStrategy::SemiJoin) {
+            unnestSurvivors(n - 1);
+        }
+        if (usesLayerTemplate()) {
+            // Empty l[n] with the layout of l[n-1], and statements prepared against it
+            layerStatements.clear();
+            checkLayerResult(conn.Query("CREATE TABLE " + layer + " AS SELECT 0 AS batch, out FROM l" + std::to_string(n - 1) + " LIMIT 0;"));
+        }
+
+        // Positions of the previous sets in l[n-1].out.sets, by colex rank; shared
+        // by every batch (the pool is drained before it goes out of scope)
+        lattice::LayerIndex prevIndex(prevAttSets);
+        for (int b = 0; b < batchCount; b++) {
+            std::vector<AttributeSet> batch(attSets.begin() + bounds[b], attSets.begin() + bounds[b + 1]);
+            std::string target = batchCount == 1 ? layer : layer + "_" + std::to_string(b);
+            if (pool) {
+                pool->submit([this, n, b, target, batch, &prevAttSets, &prevIndex](duckdb::Connection& batchConn) {
+                    runBatchQuery(batchConn, n, b, target, batch, prevAttSets, prevIndex);
+                });
+            } else {
+                runBatchQuery(conn, n, b, target, batch, prevAttSets, prevIndex);
+            }
+        }
+        if (pool) {
+            pool->wait();
+        }
+        if (usesLayerTemplate()) {
+            layerStatements.clear();
+        }
+        if (batchCount > 1) {
+            mergeBatches(n, batchCount);
+        }
+
+        if (usesRegistry()) {
+            // Layer n-1 survivors are no longer needed
+            conn.Query("SELECT drop_survivors('l" + std::to_string(n - 1) + "');");
+        }
+        if (!keepLayerTables) {
+            // Nor is the table holding them, which frees its memory (or disk) for later layers
+            conn.Query("DROP TABLE IF EXISTS l" + std::to_string(n - 1) + ";");
+            conn.Query("DROP TABLE IF EXISTS s" + std::to_string(n - 1) + ";");
+        }
+    }
+
+    /*
+        Concatenate the batch tables (or, with a layer template, the batch rows of
+        l[n]) and registered survivors of a layer.
+    */
+    void mergeBatches(int n, int batchCount) {
+        std::string layer = "l" + std::to_string(n);
+        std::string sets, entropyLists, distinctCounts, tables, keys;
+        for (int b = 0; b < batchCount; b++) {
+            std::string batch = layer + "_" + std::to_string(b);
+            sets += batch + ".out.sets, ";
+            entropyLists += batch + ".out.entropies, ";
+            distinctCounts += batch + ".out.distinct_counts, ";
+            tables += batch + ", ";
+            keys += "'" + batch + "', ";
+        }
+        for (auto* list : {&sets, &entropyLists, &distinctCounts, &tables, &keys}) {
+            list->resize(list->size() - 2); // Remove last comma
+        }
+
+        if (usesLayerTemplate()) {
+            checkLayerResult(layerQuery(conn, n,
+                "CREATE TABLE " + layer + "_merged AS SELECT struct_pack(\n"
+                "\tsets := flatten(list(out.sets ORDER BY batch)),\n"
+                "\tentropies := flatten(list(out.entropies ORDER BY batch)),\n"
+                "\tdistinct_counts := flatten(list(out.distinct_counts ORDER BY batch))\n"
+                ") AS out\nFROM " + layer + ";"
+            ));
+            conn.Query("DROP TABLE " + layer + ";");
+            conn.Query("ALTER TABLE " + layer + "_merged RENAME TO " + layer + ";");
+        } else {
+            checkLayerResult(layerQuery(conn, n,
+                "CREATE TABLE " + layer + " AS SELECT struct_pack(\n"
+                "\tsets := flatten([" + sets + "]),\n"
+                "\tentropies := flatten([" + entropyLists + "]),\n"
+                "\tdistinct_counts := flatten([" + distinctCounts + "])\n"
+                ") AS out\nFROM " + tables + ";"
+            ));
+            for (int b = 0; b < batchCount; b++) {
+                conn.Query("DROP TABLE " + layer + "_" + std::to_string(b) + ";");
+            }
+        }
+        if (usesRegistry()) {
+            checkLayerResult(layerQuery(conn, n, "SELECT merge_survivors('" + layer + "', [" + keys + "]);"));
+        }
+    }
+
+    /*
+        Create table target from the given n-sets (batch b of layer n) with the
+        configured strategy. Registry and Fused batches are inserted into l[n]
+        through the layer's template instead, with target as their survivor key.
+    */
+    void runBatchQuery(duckdb::Connection& batchConn, int n, int b, const std::string& target, const std::vector<AttributeSet>& attSets,
+                       const std::vector<AttributeSet>& prevAttSets, const lattice::LayerIndex& prevIndex) {
+        if (strategy == PruneStrategy::SemiJoin) {
+            checkLayerResult(layerQuery(batchConn, n, buildSemiJoinLayerQuery(n, target, attSets, prevAttSets, prevIndex)));
+            return;
+        }
+
+        std::string prevLayer = "l" + std::to_string(n - 1);
+        if (usesLayerTemplate()) {
+            duckdb::vector<duckdb::Value> values;
+            if (strategy == PruneStrategy::Fused) {
+                values = {
+                    duckdb::Value(prevLayer),
+                    attSetsValue(prevAttSets),
+                    attSetsValue(attSets),
+                    duckdb::Value(target),
+                    duckdb::Value::INTEGER(b)
+                };
+            } else {
+                values = {duckdb::Value(prevLayer), duckdb::Value(target), duckdb::Value::INTEGER(b)};
+                for (const auto& atts : attSets) {
+                    values.push_back(attsValue(atts));
+                    for (const auto& subset : getSubsets(atts)) {
+                        values.push_back(attsValue(subset));
+                        values.push_back(duckdb::Value::INTEGER(prevIndex.find(subset)));
+                    }
+                }
+            }
+            QueryTimings timings;
+            auto result = profiledExecute(batchConn, layerStatement(batchConn, n, attSets.size(), timings), values, timings);
+            addLayerTimings(n, timings);
+            checkLayerResult(result);
+            return;
+        }
+
+        // Filt cross joins l[n-1] to probe its nested survivor lists, so the
+        // survivors are a column, not a parameter
+        std::string survivorArg = prevLayer + ".out.sets";
+
+        std::string qry = "CREATE TABLE " + target + " AS SELECT sum_dict([\n";
+        for (auto& atts : attSets) {
+            qry += "\tCASE\n\t\tWHEN ";
+
+            std::vector<AttributeSet> subsets = getSubsets(atts);
+
+            // Iterate through atts. and remove 1 by 1 to create filtering conditions
+            for (const auto& subset : subsets) {
+                int offset = prevIndex.find(subset);
+                qry += "filt(" + hashRowExpr(subset) + ", " + survivorArg + ", " + std::to_string(offset) + ") AND\n\t\t\t";
+            }
+
+            qry.resize(qry.size() - 7); // Remove last AND\n\t\t\t
+
+            qry += "\n\t\tTHEN " + hashRowExpr(atts) + "\n\t\tELSE NULL\n\tEND,\n";
+        }
+        qry.resize(qry.size() - 2); // Remove last comma and newline
+
+        qry += "]) AS out\nFROM " + table + ", " + prevLayer + ";";
+        
+        //std::cout << qry << "\n\n";
+        checkLayerResult(layerQuery(batchConn, n, qry));
+    }
+
+    /*
+        Save the entropies of layer n's sets. The sums and distinct counts are
+        fetched in one streaming query and read straight from the result's list
+        vectors, without boxing every element in a Value. sum_dict reports
+        SUM count * log2(count) per set, so H = log2(N) - sum / N. The sums are
+        kept in layerSums to find the survivors of the layer.
+    */
+    void storeLayerEntropies(int n) {
+        layerSums.assign(layerSets.size(), 0.0);
+        auto result = conn.SendQuery("SELECT out.entropies, out.distinct_counts FROM l" + std::to_string(n) + ";");
+        auto chunk = result->HasError() ? nullptr : result->Fetch();
+        if (!chunk || chunk->size() == 0) {
+            throw std::runtime_error("Failed to read layer " + std::to_string(n) + ": " + result->GetError());
+        }
+
+        duckdb::UnifiedVectorFormat sumLists, countLists, sums, counts;
+        chunk->data[0].ToUnifiedFormat(chunk->size(), sumLists);
+        chunk->data[1].ToUnifiedFormat(chunk->size(), countLists);
+        auto& sumChild = duckdb::ListVector::GetEntry(chunk->data[0]);
+        auto& countChild = duckdb::ListVector::GetEntry(chunk->data[1]);
+        sumChild.ToUnifiedFormat(duckdb::ListVector::GetListSize(chunk->data[0]), sums);
+        countChild.ToUnifiedFormat(duckdb::ListVector::GetListSize(chunk->data[1]), counts);
+
+        auto sumEntry = duckdb::UnifiedVectorFormat::GetData<duckdb::list_entry_t>(sumLists)[sumLists.sel->get_index(0)];
+        auto countEntry = duckdb::UnifiedVectorFormat::GetData<duckdb::list_entry_t>(countLists)[countLists.sel->get_index(0)];
+        auto sumData = duckdb::UnifiedVectorFormat::GetData<double>(sums);
+        auto countData = duckdb::UnifiedVectorFormat::GetData<uint64_t>(counts);
+        for (idx_t i = 0; i < layerSets.size() && i < sumEntry.length; i++) {
+            layerSums[i] = sumData[sums.sel->get_index(sumEntry.offset + i)];
+            double entropy = tupleCount > 0 ? std::log2((double) tupleCount) - layerSums[i] / tupleCount : 0.0;
+            entropies.put(layerSets[i], entropy, countData[counts.sel->get_index(countEntry.offset + i)]);
+        }
+    }
+
+    /*
+        Returns 1 if the last stored layer holds at least one non-zero entropy sum,
+        0 otherwise.
+    */
+    int hasNonZeroEntropy() {
+        for (double sum : layerSums) {
+            if (sum != 0) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    /*
+        Compute entropies for the whole lattice with a single mine_entropies()
+        call. Attribute sets come back as column names (colN).
+
+        Streaming mines the source itself (its mined columns, which come back by
+        their source names), keeping the first scan's hashes. tbl is never loaded,
+        so the tuple count is taken from the call's rows.
+
+        mine_entropies yields the layers in order, so the first row of a larger
+        set means the previous layer is complete, and that layer is checkpointed.
+        The time and memory budgets are handed to mine_entropies, which checks
+        them after every layer (as computeEntropiesWithPruning does) and stops
+        before mining the next one.
+    */
+    void computeEntropiesNative(MiningReport& report, std::chrono::steady_clock::time_point start) {
+        // (scanned on the extension's own connection, so qualified)
+        std::string args = quoteLiteral(std::string(MINER_SCHEMA) + "." + table);
+        std::string options;
+        std::unordered_map<std::string, int> attIndex;
+        for (int i = 0; i < attributeCount; i++) {
+            attIndex["col" + std::to_string(i)] = i;
+        }
+        if (strategy == PruneStrategy::Streaming) {
+            args = quoteLiteral(sourceScan());
+            attIndex.clear();
+            for (int i = 0; i < attributeCount; i++) {
+                args += ", " + quoteLiteral(columnNames[i]);
+                attIndex[columnNames[i]] = i;
+            }
+            options += ", encode := true";
+        }
+        if (memoryBudget > 0) {
+            options += ", memory_budget := '" + std::to_string(memoryBudget) + "B'";
+        }
+        if (maxLayer > 0) {
+            options += ", max_layer := " + std::to_string(maxLayer);
+        }
+        if (timeBudget > std::chrono::steady_clock::duration::zero()) {
+            // What is left of it (loading counts too); layer 1 is always mined
+            double seconds = std::chrono::duration<double>(timeBudget).count() - secondsSince(start);
+            options += ", time_budget := " + std::to_string(std::max(seconds, 0.001));
+        }
+        if (peakMemoryBudget > 0) {
+            options += ", peak_memory_budget := '" + std::to_string(peakMemoryBudget) + "B'";
+        }
+        auto result = conn.SendQuery("SELECT attribute_set, entropy, distinct_count, tuple_count FROM mine_entropies(" + args + options + ");");
+
+        int layer = 0;
+        while (!result->HasError()) {
+            auto chunk = result->Fetch();
+            if (!chunk || chunk->size() == 0) {
+                break;
+            }
+            if (layer == 0 && strategy == PruneStrategy::Streaming) {
+                tupleCount = chunk->GetValue(3, 0).GetValue<int64_t>();
+                entropies.setTupleCount(tupleCount);
+            }
+            for (idx_t row = 0; row < chunk->size(); row++) {
+                AttributeSet atts = 0;
+                for (const auto& name : duckdb::ListValue::GetChildren(chunk->GetValue(0, row))) {
+                    atts = lattice::withAtt(atts, attIndex.at(name.ToString()));
+                }
+                if (lattice::attCount(atts) > layer) {
+                    if (layer > 0) {
+                        checkpointLayer(report, layer);
+                    }
+                    layer = lattice::attCount(atts);
+                }
+                entropies.put(atts, chunk->GetValue(1, row).GetValue<double>(), chunk->GetValue(2, row).GetValue<uint64_t>());
+            }
+            if (printLayers) {
+                chunk->Print();
+            }
+        }
+        if (result->HasError()) {
+            // Layers up to the previous one are complete (and checkpointed)
+            report.reason = StopReason::Failed;
+            report.error = result->GetError();
+            return;
+        }
+
+        checkpointLayer(report, layer);
+        // mine_entropies doesn't say why it stopped; a budget it stopped for is still exceeded here
+        report.reason = StopReason::Exhausted;
+        if (layer < attributeCount) {
+            if (maxLayer > 0 && layer >= maxLayer) {
+                report.reason = StopReason::MaxLayer;
+            } else if (!budgetExceeded(report, start)) {
+                report.reason = StopReason::Exhausted;
+            }
+        }
+    }
+
+    // Count layer as complete and save the entropies mined so far to the checkpoint (if any)
+    void checkpointLayer(MiningReport& report, int layer) {
+        report.completeLayers = layer;
+        if (!checkpointPath.empty()) {
+            saveEntropies(checkpointPath);
+        }
+    }
+
+    // Whether the time or memory budget is used up (the reason is set in report)
+    bool budgetExceeded(MiningReport& report, std::chrono::steady_clock::time_point start) {
+        if (timeBudget > std::chrono::steady_clock::duration::zero() && std::chrono::steady_clock::now() - start >= timeBudget) {
+            report.reason = StopReason::Deadline;
+            return true;
+        }
+        if (peakMemoryBudget > 0 && peakMemoryBytes() >= peakMemoryBudget) {
+            report.reason = StopReason::Memory;
+            return true;
+        }
+        return false;
+    }
+
+    /*
+        Compute entropies for all set (unless no n-sets are found) at which point we stop
+        and prune individual tuples at each stage.
+
+        Mining also stops after a layer that reaches the max layer or exceeds the
+        time or memory budget. The entropies of every layer computed so far are
+        kept (and checkpointed), and the report says which layers are complete.
+    */
+    MiningReport computeEntropiesWithPruning() {
+        MiningReport report;
+        auto start = std::chrono::steady_clock::now();
+
+        if (strategy == PruneStrategy::Native || strategy == PruneStrategy::Streaming) {
+            // The extension mines in a single call, stopped between layers
+            computeEntropiesNative(report, start);
+            finishReport(report, start);
+            return report;
+        }
+
+        int lastLayer = maxLayer > 0 ? std::min(maxLayer, attributeCount) : attributeCount;
+        for (int layer = 1; layer <= lastLayer; layer++) {
+            bool hasResults = true;
+            try {
+                if (layer == 1) {
+                    computeFirstLayer();
+                } else {
+                    hasResults = computeSingleLayer(layer);
+                }
+            } catch (std::exception& e) {
+                // Layers up to the previous one are complete (and checkpointed)
+                report.reason = StopReason::Failed;
+                report.error = e.what();
+                break;
+            }
+            checkpointLayer(report, layer);
+
+            if (!hasResults || layer == attributeCount) {
+                // No valid n-sets left
+                report.reason = StopReason::Exhausted;
+                break;
+            }
+            if (layer == lastLayer) {
+                report.reason = StopReason::MaxLayer;
+                break;
+            }
+            if (budgetExceeded(report, start)) {
+                break;
+            }
+        }
+
+        finishReport(report, start);
+        return report;
+    }
+
+    void finishReport(MiningReport& report, std::chrono::steady_clock::time_point start) {
+        report.layerSetCounts.assign(report.completeLayers + 1, 0);
+        entropies.forEach([&](const lattice::EntropyRecord& record) {
+            int layer = lattice::attCount(record.mask);
+            if (layer <= report.completeLayers) {
+                report.layerSetCounts[layer]++;
+            }
+        });
+        report.seconds = secondsSince(start);
+        report.peakMemory = peakMemoryBytes();
+    }
+
+    void printReport(const MiningReport& report) {
+        std::cout << "Stopped: " << stopReasonName(report.reason) << " after " << std::fixed << std::setprecision(1)
+                  << report.seconds << "s, peak memory " << report.peakMemory / (1024 * 1024) << "MiB\n"
+                  << std::defaultfloat;
+        if (report.reason == StopReason::Failed) {
+            std::cout << "\033[1;31mLayer " << report.completeLayers + 1 << " failed: \033[0m" << report.error << "\n";
+        }
+        std::cout << "Complete layers: 1-" << report.completeLayers;
+        if (report.reason == StopReason::Exhausted) {
+            std::cout << " (larger sets are all supersets of keys)";
+        } else if (report.completeLayers < attributeCount) {
+            std::cout << " (layers " << report.completeLayers + 1 << "-" << attributeCount << " not mined)";
+        }
+        std::cout << "\n";
+        for (int layer = 1; layer <= report.completeLayers; layer++) {
+            std::cout << "  layer " << layer << ": " << report.layerSetCounts[layer] << " sets\n";
+        }
+    }
+};
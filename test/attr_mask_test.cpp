@@ -0,0 +1,77 @@
+#include "attr_mask.hpp"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+
+/*
+    Checks the attribute set helpers, in particular that WideAttrMask agrees with
+    AttrMask on sets that fit in one word and handles attributes past 64.
+
+    Usage: attr_mask_test (exits with 1 on the first failed check)
+*/
+
+using lattice::AttrMask;
+using Wide = lattice::WideAttrMask<2>;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        failures++;
+    }
+}
+
+int main() {
+    // Same sets, single and two words
+    std::vector<std::vector<int>> lists = {{0, 3}, {0, 5}, {1, 2}, {2, 63}, {0, 1}};
+    std::vector<AttrMask> narrow;
+    std::vector<Wide> wide;
+    for (const auto& list : lists) {
+        narrow.push_back(lattice::fromAtts(list));
+        wide.push_back(lattice::fromAtts<Wide>(list));
+    }
+    for (size_t i = 0; i < lists.size(); i++) {
+        check(lattice::toAtts(wide[i]) == lists[i], "wide toAtts round trip");
+        check(attCount(wide[i]) == lattice::attCount(narrow[i]), "wide attCount");
+        check(lowestAtt(wide[i]) == lattice::lowestAtt(narrow[i]), "wide lowestAtt");
+        check(highestAtt(wide[i]) == lattice::highestAtt(narrow[i]), "wide highestAtt");
+        for (size_t j = 0; j < lists.size(); j++) {
+            check(lexLess(wide[i], wide[j]) == lattice::lexLess(narrow[i], narrow[j]), "wide lexLess agrees");
+            check(isSubset(wide[i], wide[j]) == lattice::isSubset(narrow[i], narrow[j]), "wide isSubset agrees");
+        }
+    }
+
+    // The single-word comparator can be passed as is
+    std::sort(narrow.begin(), narrow.end(), lattice::lexLess);
+    check(lattice::toAtts(narrow[0]) == std::vector<int>({0, 1}), "sorted by lexLess");
+    check(lattice::toAtts(narrow[4]) == std::vector<int>({2, 63}), "sorted by lexLess");
+
+    // Attributes past the first word
+    Wide set = lattice::fromAtts<Wide>({5, 64, 100});
+    check(attCount(set) == 3, "attCount past 64");
+    check(hasAtt(set, 64) && hasAtt(set, 100) && !hasAtt(set, 0), "hasAtt past 64");
+    check(highestAtt(set) == 100, "highestAtt past 64");
+    check(withoutAtt(set, 64) == lattice::fromAtts<Wide>({5, 100}), "withoutAtt past 64");
+    check(withAtt(set, 127) == (set | lattice::wideAttBit<2>(127)), "withAtt past 64");
+    check(isSubset(lattice::wideAttBit<2>(100), set), "isSubset past 64");
+    check(lexLess(lattice::fromAtts<Wide>({5, 64}), lattice::fromAtts<Wide>({5, 100})), "lexLess past 64");
+    check(!lexLess(lattice::fromAtts<Wide>({6, 64}), lattice::fromAtts<Wide>({5, 100})), "lexLess past 64");
+
+    std::vector<int> visited;
+    forEachAtt(set, [&](int att) {
+        visited.push_back(att);
+    });
+    check(visited == std::vector<int>({5, 64, 100}), "forEachAtt past 64");
+
+    std::unordered_set<Wide> sets = {set, withoutAtt(set, 64), set};
+    check(sets.size() == 2, "std::hash of wide sets");
+
+    if (failures) {
+        return 1;
+    }
+    std::cout << "attr_mask_test: all checks passed\n";
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "entropy_store.hpp"
+
+#include <cstdio>
+#include <string>
+#include <iostream>
+
+/*
+    Checks that entropy stores survive a save and map round trip, and that
+    malformed store files are rejected when they are opened.
+
+    Usage: entropy_store_test (exits with 1 on the first failed check)
+*/
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        failures++;
+    }
+}
+
+// Whether opening path as a store is rejected
+bool rejected(const std::string& path) {
+    try {
+        lattice::MappedEntropyStore store(path);
+    } catch (std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// Write a store header followed by slotCount empty slots
+void writeStore(const std::string& path, uint64_t capacity, uint64_t size, uint64_t slotCount) {
+    lattice::StoreHeader header;
+    std::memcpy(header.magic, lattice::STORE_MAGIC, sizeof(lattice::STORE_MAGIC));
+    header.version = lattice::STORE_VERSION;
+    header.capacity = capacity;
+    header.size = size;
+    header.tupleCount = 1;
+    FILE *file = std::fopen(path.c_str(), "wb");
+    std::fwrite(&header, sizeof(header), 1, file);
+    lattice::EntropyRecord empty{0, 0.0, 0};
+    for (uint64_t i = 0; i < slotCount; i++) {
+        std::fwrite(&empty, sizeof(empty), 1, file);
+    }
+    std::fclose(file);
+}
+
+int main() {
+    std::string path = "entropy_store_test.store";
+
+    lattice::EntropyStore store;
+    store.setTupleCount(5);
+    for (lattice::AttrMask mask = 1; mask < 100; mask++) {
+        store.put(mask, mask / 10.0, mask);
+    }
+    store.save(path);
+    {
+        lattice::MappedEntropyStore mapped(path);
+        check(mapped.getTupleCount() == 5, "tuple count round trip");
+        bool found = true;
+        for (lattice::AttrMask mask = 1; mask < 100; mask++) {
+            auto record = mapped.find(mask);
+            found = found && record && record->entropy == mask / 10.0 && record->distinctCount == mask;
+        }
+        check(found, "every set found after the round trip");
+        check(!mapped.find(100), "a set that wasn't stored isn't found");
+    }
+
+    // A full table (no empty slot to end a probe) and sizes that don't match the file
+    writeStore(path, 4, 4, 4);
+    check(rejected(path), "size >= capacity is rejected");
+    writeStore(path, 4, 1, 3);
+    check(rejected(path), "missing slots are rejected");
+    // (2^61 * sizeof(EntropyRecord) wraps to 0, matching a header-only file)
+    writeStore(path, uint64_t(1) << 61, 1, 0);
+    check(rejected(path), "a capacity whose byte size overflows is rejected");
+    writeStore(path, 4, 1, 4);
+    check(!rejected(path), "a well-formed empty store opens");
+
+    std::remove(path.c_str());
+    if (failures) {
+        return 1;
+    }
+    std::cout << "entropy_store_test: all checks passed\n";
+    return 0;
+}
@@ -0,0 +1,247 @@
+#include "entropy_store.hpp"
+#include "lattice.hpp"
+
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+    Runs the main binary on a small CSV dataset and checks the entropy stores it
+    writes: every strategy against Native, with a connection pool, sampling and key
+    verification, --max-layer, a budget stop (whose store is the last layer's
+    checkpoint), hashed cells kept in a dataset cache that is rebuilt when the
+    file's mtime or content changes, and a glob of files loaded concurrently.
+
+    Usage: miner_test <main binary> <dataset.csv> <extension> (exits with 1 if a
+    check fails, and with 77 when the binary or extension isn't built)
+*/
+
+namespace fs = std::filesystem;
+
+const int SKIPPED = 77;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        failures++;
+    }
+}
+
+std::string mainPath;
+std::string extensionPath;
+fs::path scratch;
+
+std::string shellQuoted(const std::string& arg) {
+    return "'" + arg + "'";
+}
+
+// Run main on dataset with args, writing its entropy store to output; true if it exits with 0
+bool mine(const std::string& dataset, const std::string& output, const std::string& args = "") {
+    std::string log = (scratch / "main.log").string();
+    std::string command = shellQuoted(mainPath) + " " + shellQuoted(dataset) + " --extension " + shellQuoted(extensionPath) +
+                          " --output " + shellQuoted(output) + " " + args + " > " + shellQuoted(log) + " 2>&1";
+    int status = std::system(command.c_str());
+    if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::ifstream in(log);
+        std::cerr << command << "\n" << in.rdbuf() << "\n";
+        return false;
+    }
+    return true;
+}
+
+uint64_t largestSet(const lattice::MappedEntropyStore& store) {
+    uint64_t largest = 0;
+    store.forEach([&](const lattice::EntropyRecord& record) {
+        largest = std::max<uint64_t>(largest, lattice::attCount(record.mask));
+    });
+    return largest;
+}
+
+/*
+    Whether actual holds exactly expected's sets of up to maxSize atts. (all of
+    them with maxSize 0) with the same entropies and distinct counts.
+*/
+bool sameEntropies(const lattice::MappedEntropyStore& expected, const lattice::MappedEntropyStore& actual, uint64_t maxSize = 0) {
+    uint64_t compared = 0;
+    bool same = expected.getTupleCount() == actual.getTupleCount();
+    expected.forEach([&](const lattice::EntropyRecord& record) {
+        if (maxSize > 0 && (uint64_t) lattice::attCount(record.mask) > maxSize) {
+            return;
+        }
+        compared++;
+        auto found = actual.find(record.mask);
+        same = same && found && std::fabs(found->entropy - record.entropy) < 1e-9 && found->distinctCount == record.distinctCount;
+    });
+    return same && compared == actual.size();
+}
+
+// Mine dataset with args and compare the result with expected (up to maxSize atts.)
+void checkRun(const lattice::MappedEntropyStore& expected, const std::string& dataset, const std::string& args,
+              const std::string& what, uint64_t maxSize = 0) {
+    std::string output = (scratch / "run.store").string();
+    fs::remove(output);
+    if (!mine(dataset, output, args)) {
+        check(false, what + ": main failed");
+        return;
+    }
+    lattice::MappedEntropyStore actual(output);
+    check(sameEntropies(expected, actual, maxSize), what + ": entropies differ from native");
+}
+
+void checkStrategies(const lattice::MappedEntropyStore& native, const std::string& dataset) {
+    for (const std::string strategy : {"filt", "semi-join", "registry", "fused", "streaming"}) {
+        checkRun(native, dataset, "--strategy " + strategy, strategy);
+        // Layers split into batches run at once on the pool's connections
+        checkRun(native, dataset, "--strategy " + strategy + " --concurrency 3", strategy + " on a pool");
+    }
+    // Sampled candidates ordered by estimate, and likely keys verified instead of counted
+    for (const std::string strategy : {"filt", "registry", "fused"}) {
+        checkRun(native, dataset, "--strategy " + strategy + " --sample-rows 16", strategy + " sampled");
+    }
+}
+
+void checkMaxLayer(const lattice::MappedEntropyStore& native, const std::string& dataset) {
+    for (const std::string strategy : {"filt", "fused", "native"}) {
+        checkRun(native, dataset, "--strategy " + strategy + " --max-layer 2", strategy + " --max-layer 2", 2);
+    }
+}
+
+/*
+    Any process is past a 1KB peak memory budget, so mining stops after layer 1;
+    the store written is layer 1's checkpoint. (There is no option to resume
+    mining from a checkpoint; it only keeps the complete layers.)
+*/
+void checkBudgetStop(const lattice::MappedEntropyStore& native, const std::string& dataset) {
+    for (const std::string strategy : {"filt", "native"}) {
+        std::string output = (scratch / "stopped.store").string();
+        fs::remove(output);
+        if (!mine(dataset, output, "--strategy " + strategy + " --memory-budget 1KB")) {
+            check(false, strategy + " budget stop: main failed");
+            continue;
+        }
+        lattice::MappedEntropyStore stopped(output);
+        check(largestSet(stopped) == 1, strategy + " budget stop: only layer 1 is kept");
+        check(sameEntropies(native, stopped, 1), strategy + " budget stop: layer 1 differs from native");
+    }
+}
+
+fs::file_time_type stale() {
+    return fs::file_time_type(std::chrono::hours(24));
+}
+
+/*
+    A cache is reused while the dataset is unchanged and rebuilt (rewritten) when
+    its mtime or content changes; every run must mine the file as it is now.
+*/
+void checkCache(const std::string& dataset) {
+    fs::path copy = scratch / "cached.csv";
+    fs::copy_file(dataset, copy, fs::copy_options::overwrite_existing);
+    std::string cache = (scratch / "dataset.cache").string();
+    std::string expectedPath = (scratch / "cache_expected.store").string();
+    auto mineCopy = [&](const std::string& what) {
+        // The cache stores hashed cells, so compare with hashed cells mined without it
+        if (!mine(copy.string(), expectedPath, "--strategy native --hash-cells")) {
+            check(false, what + ": main failed without the cache");
+            return;
+        }
+        lattice::MappedEntropyStore expected(expectedPath);
+        checkRun(expected, copy.string(), "--strategy native --cache " + shellQuoted(cache), what);
+    };
+
+    mineCopy("cache written");
+    if (!fs::exists(cache)) {
+        check(false, "cache written: the cache file exists");
+        return;
+    }
+    // Its mtime marks whether a later run rewrote it
+    fs::last_write_time(cache, stale());
+    mineCopy("cache reused");
+    check(fs::last_write_time(cache) == stale(), "cache reused: the unchanged dataset's cache is kept");
+
+    // Same content, later mtime
+    fs::last_write_time(copy, fs::last_write_time(copy) + std::chrono::seconds(10));
+    mineCopy("cache after touch");
+    check(fs::last_write_time(cache) != stale(), "cache after touch: the cache is rebuilt");
+
+    // Same size and mtime, one value changed
+    fs::last_write_time(cache, stale());
+    auto mtime = fs::last_write_time(copy);
+    {
+        std::fstream file(copy, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(0);
+        file.put('3');
+    }
+    fs::last_write_time(copy, mtime);
+    mineCopy("cache after edit");
+    check(fs::last_write_time(cache) != stale(), "cache after edit: the cache is rebuilt");
+}
+
+// The dataset split into files mined as one glob, loaded in parallel
+void checkGlob(const lattice::MappedEntropyStore& native, const std::string& dataset) {
+    fs::path parts = scratch / "parts";
+    fs::create_directories(parts);
+    std::ifstream in(dataset);
+    std::vector<std::ofstream> files;
+    for (int i = 0; i < 3; i++) {
+        files.emplace_back(parts / ("part-" + std::to_string(i) + ".csv"));
+    }
+    std::string line;
+    for (int row = 0; std::getline(in, line); row++) {
+        files[row % files.size()] << line << "\n";
+    }
+    files.clear();
+
+    std::string glob = (parts / "part-*.csv").string();
+    checkRun(native, glob, "--strategy native --load-concurrency 2", "glob");
+    checkRun(native, glob, "--strategy filt --load-concurrency 3", "glob with filt");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        std::cerr << "Usage: miner_test <main binary> <dataset.csv> <extension>\n";
+        return 1;
+    }
+    mainPath = fs::absolute(argv[1]).string();
+    std::string dataset = fs::absolute(argv[2]).string();
+    extensionPath = fs::absolute(argv[3]).string();
+    if (!fs::exists(mainPath) || !fs::exists(extensionPath)) {
+        std::cerr << "miner_test: skipped (" << mainPath << " or " << extensionPath << " is not built)\n";
+        return SKIPPED;
+    }
+
+    scratch = fs::temp_directory_path() / ("miner_test_" + std::to_string(::getpid()));
+    fs::remove_all(scratch);
+    fs::create_directories(scratch);
+
+    std::string nativePath = (scratch / "native.store").string();
+    if (!mine(dataset, nativePath, "--strategy native")) {
+        std::cerr << "FAILED: native run\n";
+        fs::remove_all(scratch);
+        return 1;
+    }
+    lattice::MappedEntropyStore native(nativePath);
+    check(largestSet(native) > 2, "the dataset has layers past 2");
+
+    checkStrategies(native, dataset);
+    checkMaxLayer(native, dataset);
+    checkBudgetStop(native, dataset);
+    checkCache(dataset);
+    checkGlob(native, dataset);
+
+    fs::remove_all(scratch);
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "miner_test: all checks passed\n";
+    return 0;
+}